@@ -0,0 +1,229 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Classes for conditional branch direction predictors
+**************************************************************** */
+
+#include "BranchPredictor.h"
+
+// Constructor
+BranchPredictor::BranchPredictor(string name)
+{
+    this->name = name;
+}
+
+// create a predictor by name, NULL if unknown
+BranchPredictor* BranchPredictor::create(string name)
+{
+    if (name == "static") return new StaticPredictor();
+    if (name == "bimodal") return new BimodalPredictor(12);
+    if (name == "gshare") return new GsharePredictor(14);
+    if (name == "tage") return new TagePredictor();
+    return NULL;
+}
+
+// return predictor name
+string BranchPredictor::getName()
+{
+    return name;
+}
+
+// destructor
+BranchPredictor::~BranchPredictor()
+{
+
+}
+
+/* ****************************************************************
+   Static backward taken, forward not taken
+**************************************************************** */
+
+StaticPredictor::StaticPredictor() : BranchPredictor("static")
+{
+
+}
+
+bool StaticPredictor::predict(uint64_t pc, bool backward)
+{
+    return backward;
+}
+
+void StaticPredictor::update(uint64_t pc, bool taken)
+{
+
+}
+
+/* ****************************************************************
+   Bimodal
+**************************************************************** */
+
+BimodalPredictor::BimodalPredictor(unsigned int index_bits) : BranchPredictor("bimodal")
+{
+    this->index_bits = index_bits;
+    counters.assign(1u << index_bits, 1);   // weakly not taken
+}
+
+bool BimodalPredictor::predict(uint64_t pc, bool backward)
+{
+    return counters[(pc >> 1) & ((1u << index_bits) - 1)] >= 2;
+}
+
+void BimodalPredictor::update(uint64_t pc, bool taken)
+{
+    uint8_t& counter = counters[(pc >> 1) & ((1u << index_bits) - 1)];
+    if (taken && counter < 3) counter++;
+    if (!taken && counter > 0) counter--;
+}
+
+/* ****************************************************************
+   Gshare
+**************************************************************** */
+
+GsharePredictor::GsharePredictor(unsigned int index_bits) : BranchPredictor("gshare")
+{
+    this->index_bits = index_bits;
+    counters.assign(1u << index_bits, 1);
+    history = 0;
+}
+
+bool GsharePredictor::predict(uint64_t pc, bool backward)
+{
+    return counters[((pc >> 1) ^ history) & ((1u << index_bits) - 1)] >= 2;
+}
+
+void GsharePredictor::update(uint64_t pc, bool taken)
+{
+    uint8_t& counter = counters[((pc >> 1) ^ history) & ((1u << index_bits) - 1)];
+    if (taken && counter < 3) counter++;
+    if (!taken && counter > 0) counter--;
+    history = (history << 1) | (taken ? 1 : 0);
+}
+
+/* ****************************************************************
+   TAGE-lite
+**************************************************************** */
+
+TagePredictor::TagePredictor() : BranchPredictor("tage")
+{
+    base.assign(4096, 1);
+    for (unsigned int t = 0; t < num_tables; t++)
+    {
+        Entry empty = {0, 0, 0, false};
+        tables[t].assign(1u << index_bits, empty);
+    }
+    history_length[0] = 5;
+    history_length[1] = 12;
+    history_length[2] = 26;
+    history_length[3] = 56;
+    history = 0;
+    branches = 0;
+    rng = 0x2545f4914f6cdd1dULL;
+    provider = -1;
+    provider_pred = false;
+    alt_pred = false;
+}
+
+// fold the most recent length history bits into bits
+uint64_t TagePredictor::fold(unsigned int length, unsigned int bits)
+{
+    uint64_t h = length >= 64 ? history : history & ((1ULL << length) - 1);
+    uint64_t folded = 0;
+    while (h != 0)
+    {
+        folded ^= h & ((1ULL << bits) - 1);
+        h >>= bits;
+    }
+    return folded;
+}
+
+bool TagePredictor::predict(uint64_t pc, bool backward)
+{
+    uint64_t p = pc >> 1;
+    bool base_pred = base[p & 4095] >= 2;
+
+    // find the longest and second longest matching tables
+    provider = -1;
+    int alt = -1;
+    for (int t = num_tables - 1; t >= 0; t--)
+    {
+        index[t] = (p ^ (p >> index_bits) ^ fold(history_length[t], index_bits)) & ((1u << index_bits) - 1);
+        tag[t] = (p ^ fold(history_length[t], tag_bits) ^ (fold(history_length[t], tag_bits - 1) << 1)) & ((1u << tag_bits) - 1);
+        if (tables[t][index[t]].valid && tables[t][index[t]].tag == tag[t])
+        {
+            if (provider < 0) provider = t;
+            else if (alt < 0) alt = t;
+        }
+    }
+
+    alt_pred = alt >= 0 ? tables[alt][index[alt]].counter >= 0 : base_pred;
+    provider_pred = provider >= 0 ? tables[provider][index[provider]].counter >= 0 : base_pred;
+    return provider_pred;
+}
+
+void TagePredictor::update(uint64_t pc, bool taken)
+{
+    uint64_t p = pc >> 1;
+
+    if (provider >= 0)
+    {
+        Entry& entry = tables[provider][index[provider]];
+        if (taken && entry.counter < 3) entry.counter++;
+        if (!taken && entry.counter > -4) entry.counter--;
+
+        // useful when the provider was right and the alternate wrong
+        if (provider_pred != alt_pred)
+        {
+            if (provider_pred == taken && entry.useful < 3) entry.useful++;
+            if (provider_pred != taken && entry.useful > 0) entry.useful--;
+        }
+    }
+    else
+    {
+        uint8_t& counter = base[p & 4095];
+        if (taken && counter < 3) counter++;
+        if (!taken && counter > 0) counter--;
+    }
+
+    // on a misprediction allocate an entry in a longer table
+    if (provider_pred != taken && provider < (int) num_tables - 1)
+    {
+        bool allocated = false;
+        unsigned int start = provider + 1;
+
+        // skip a table at random to spread allocations
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        if (start < num_tables - 1 && (rng & 1)) start++;
+
+        for (unsigned int t = start; t < num_tables; t++)
+        {
+            Entry& entry = tables[t][index[t]];
+            if (entry.useful == 0)
+            {
+                entry.tag = tag[t];
+                entry.counter = taken ? 0 : -1;
+                entry.valid = true;
+                allocated = true;
+                break;
+            }
+        }
+        if (!allocated)
+        {
+            for (unsigned int t = provider + 1; t < num_tables; t++)
+            {
+                if (tables[t][index[t]].useful > 0) tables[t][index[t]].useful--;
+            }
+        }
+    }
+
+    // age useful bits periodically
+    if ((++branches & 0x3ffff) == 0)
+    {
+        for (unsigned int t = 0; t < num_tables; t++)
+        {
+            for (size_t i = 0; i < tables[t].size(); i++) tables[t][i].useful >>= 1;
+        }
+    }
+
+    history = (history << 1) | (taken ? 1 : 0);
+}
@@ -0,0 +1,125 @@
+#ifndef BRANCHPREDICTOR_H
+#define BRANCHPREDICTOR_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Classes for conditional branch direction predictors
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+// base class for direction predictors
+class BranchPredictor {
+
+    protected:
+
+        string name;
+
+    public:
+
+        // Constructor
+        BranchPredictor(string name);
+
+        // create a predictor by name ("static", "bimodal", "gshare" or "tage"), NULL if unknown
+        static BranchPredictor* create(string name);
+
+        // predict direction of the branch at pc, backward when the offset is negative
+        virtual bool predict(uint64_t pc, bool backward) = 0;
+
+        // train with the resolved direction of the last predicted branch
+        virtual void update(uint64_t pc, bool taken) = 0;
+
+        // return predictor name
+        string getName();
+
+        // destructor
+        virtual ~BranchPredictor();
+};
+
+// static backward taken, forward not taken
+class StaticPredictor : public BranchPredictor {
+
+    public:
+
+        StaticPredictor();
+        bool predict(uint64_t pc, bool backward) override;
+        void update(uint64_t pc, bool taken) override;
+};
+
+// table of 2-bit saturating counters indexed by pc
+class BimodalPredictor : public BranchPredictor {
+
+    private:
+
+        vector<uint8_t> counters;
+        unsigned int index_bits;
+
+    public:
+
+        BimodalPredictor(unsigned int index_bits);
+        bool predict(uint64_t pc, bool backward) override;
+        void update(uint64_t pc, bool taken) override;
+};
+
+// 2-bit counters indexed by pc xor global history
+class GsharePredictor : public BranchPredictor {
+
+    private:
+
+        vector<uint8_t> counters;
+        unsigned int index_bits;
+        uint64_t history;
+
+    public:
+
+        GsharePredictor(unsigned int index_bits);
+        bool predict(uint64_t pc, bool backward) override;
+        void update(uint64_t pc, bool taken) override;
+};
+
+// bimodal base with tagged tables over geometric global history lengths
+class TagePredictor : public BranchPredictor {
+
+    private:
+
+        struct Entry
+        {
+            uint16_t tag;
+            int8_t counter;     // 3-bit signed, taken when >= 0
+            uint8_t useful;     // 2-bit
+            bool valid;         // allocated, so a computed tag of 0 does not match an empty entry
+        };
+
+        static const unsigned int num_tables = 4;
+        static const unsigned int index_bits = 10;
+        static const unsigned int tag_bits = 9;
+
+        vector<uint8_t> base;
+        vector<Entry> tables[num_tables];
+        unsigned int history_length[num_tables];
+        uint64_t history;
+        uint64_t branches;
+        uint64_t rng;
+
+        // lookup state from the last prediction
+        unsigned int index[num_tables];
+        uint16_t tag[num_tables];
+        int provider;
+        bool provider_pred;
+        bool alt_pred;
+
+        // fold the most recent length history bits into bits
+        uint64_t fold(unsigned int length, unsigned int bits);
+
+    public:
+
+        TagePredictor();
+        bool predict(uint64_t pc, bool backward) override;
+        void update(uint64_t pc, bool taken) override;
+};
+
+#endif
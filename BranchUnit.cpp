@@ -0,0 +1,210 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for branch prediction unit with BTB and return address stack
+**************************************************************** */
+
+#include "BranchUnit.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Constructor
+BranchUnit::BranchUnit()
+{
+    btb_pc.assign(1u << btb_bits, UINT64_MAX);
+    btb_target.assign(1u << btb_bits, 0);
+    ras.assign(ras_size, 0);
+    ras_top = 0;
+    ras_count = 0;
+
+    branches = 0;
+    taken_branches = 0;
+    target_mispredicts = 0;
+    jumps = 0;
+    jump_mispredicts = 0;
+    returns = 0;
+    return_mispredicts = 0;
+    indirects = 0;
+    indirect_mispredicts = 0;
+}
+
+// add a direction predictor
+void BranchUnit::addPredictor(BranchPredictor* predictor)
+{
+    predictors.push_back(predictor);
+    mispredicts.push_back(0);
+}
+
+// return BTB target for pc, or 0 on a miss
+// the BTB and predictor tables are indexed by halfword so compressed transfers in one word do not alias
+uint64_t BranchUnit::btbLookup(uint64_t pc)
+{
+    unsigned int index = (pc >> 1) & ((1u << btb_bits) - 1);
+    if (btb_pc[index] != pc) return 0;
+    return btb_target[index];
+}
+
+// install a taken target in the BTB
+void BranchUnit::btbUpdate(uint64_t pc, uint64_t target)
+{
+    unsigned int index = (pc >> 1) & ((1u << btb_bits) - 1);
+    btb_pc[index] = pc;
+    btb_target[index] = target;
+}
+
+// push a return address, overwriting the oldest when full
+void BranchUnit::rasPush(uint64_t address)
+{
+    ras_top = (ras_top + 1) % ras_size;
+    ras[ras_top] = address;
+    if (ras_count < ras_size) ras_count++;
+}
+
+// pop a return address, 0 when empty
+uint64_t BranchUnit::rasPop()
+{
+    if (ras_count == 0) return 0;
+    uint64_t address = ras[ras_top];
+    ras_top = (ras_top + ras_size - 1) % ras_size;
+    ras_count--;
+    return address;
+}
+
+// predict and train on a retired instruction
+bool BranchUnit::resolve(const RetiredIns& rec)
+{
+    Ins code = rec.code;
+    bool link = rec.rd == 1 || rec.rd == 5;
+
+    // transfers interrupted by a trap are not resolved
+    if (rec.trap) return false;
+
+    if (code == ins_jal)
+    {
+        // target comes from the BTB at fetch
+        bool miss = btbLookup(rec.pc) != rec.next_pc;
+        jumps++;
+        if (miss) jump_mispredicts++;
+        btbUpdate(rec.pc, rec.next_pc);
+        if (link) rasPush(rec.pc + rec.len);
+        return miss;
+    }
+
+    if (code == ins_jalr)
+    {
+        // returns use the return address stack, other indirect jumps the BTB
+        bool is_return = rec.rd == 0 && (rec.rs1 == 1 || rec.rs1 == 5);
+        bool miss;
+        if (is_return)
+        {
+            miss = rasPop() != rec.next_pc;
+            returns++;
+            if (miss) return_mispredicts++;
+        }
+        else
+        {
+            miss = btbLookup(rec.pc) != rec.next_pc;
+            indirects++;
+            if (miss) indirect_mispredicts++;
+            btbUpdate(rec.pc, rec.next_pc);
+        }
+        if (link) rasPush(rec.pc + rec.len);
+        return miss;
+    }
+
+    if (code < ins_beq || code > ins_bgeu) return false;
+
+    bool taken = rec.next_pc != rec.pc + rec.len;
+    bool backward = (rec.ins >> 31) & 0x1;
+    bool mispredict = false;
+
+    BranchStats& stats = branch_stats[rec.pc];
+    if (stats.mispredicts.size() != predictors.size()) stats.mispredicts.assign(predictors.size(), 0);
+    stats.count++;
+    branches++;
+    if (taken)
+    {
+        stats.taken++;
+        taken_branches++;
+    }
+
+    for (size_t i = 0; i < predictors.size(); i++)
+    {
+        bool prediction = predictors[i]->predict(rec.pc, backward);
+        predictors[i]->update(rec.pc, taken);
+        if (prediction != taken)
+        {
+            mispredicts[i]++;
+            stats.mispredicts[i]++;
+            if (i == 0) mispredict = true;
+        }
+    }
+
+    // a correctly predicted taken branch also needs its target from the BTB
+    if (taken)
+    {
+        if (!mispredict && btbLookup(rec.pc) != rec.next_pc)
+        {
+            target_mispredicts++;
+            mispredict = true;
+        }
+        btbUpdate(rec.pc, rec.next_pc);
+    }
+
+    return mispredict;
+}
+
+// print accuracy per predictor and for the most mispredicted branches
+void BranchUnit::printStats()
+{
+    cout << fixed << setprecision(2);
+    cout << "Conditional branches: " << dec << branches << ", taken: " << taken_branches << endl;
+    for (size_t i = 0; i < predictors.size(); i++)
+    {
+        cout << "Predictor " << predictors[i]->getName() << ": " << mispredicts[i] << " mispredictions";
+        if (branches) cout << ", accuracy: " << 100.0 - 100.0 * mispredicts[i] / branches << "%";
+        cout << endl;
+    }
+    cout << "BTB target misses (taken branches): " << target_mispredicts << endl;
+    cout << "BTB jal: " << jumps << ", misses: " << jump_mispredicts << endl;
+    cout << "BTB indirect jalr: " << indirects << ", mispredictions: " << indirect_mispredicts << endl;
+    cout << "RAS returns: " << returns << ", mispredictions: " << return_mispredicts << endl;
+
+    // ten branches with the most mispredictions by the first predictor
+    vector<pair<uint64_t,uint64_t>> worst;
+    for (unordered_map<uint64_t,BranchStats>::iterator it = branch_stats.begin(); it != branch_stats.end(); ++it)
+    {
+        if (!predictors.empty()) worst.push_back(make_pair(it->second.mispredicts[0], it->first));
+    }
+    sort(worst.rbegin(), worst.rend());
+    if (worst.size() > 10) worst.resize(10);
+
+    if (!worst.empty())
+    {
+        cout << "Most mispredicted branches:" << endl;
+        cout << "  pc               count      taken%";
+        for (size_t i = 0; i < predictors.size(); i++) cout << " " << setfill(' ') << setw(9) << predictors[i]->getName();
+        cout << endl;
+        for (size_t w = 0; w < worst.size(); w++)
+        {
+            BranchStats& stats = branch_stats[worst[w].second];
+            cout << "  " << setw(16) << setfill('0') << hex << worst[w].second << setfill(' ') << dec
+                 << " " << setw(10) << stats.count << " " << setw(7) << 100.0 * stats.taken / stats.count;
+            for (size_t i = 0; i < predictors.size(); i++)
+            {
+                cout << " " << setw(8) << 100.0 - 100.0 * stats.mispredicts[i] / stats.count << "%";
+            }
+            cout << endl;
+        }
+    }
+    cout << defaultfloat << setprecision(6);
+}
+
+// destructor
+BranchUnit::~BranchUnit()
+{
+    for (size_t i = 0; i < predictors.size(); i++)
+    {
+        delete predictors[i];
+    }
+}
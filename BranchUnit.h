@@ -0,0 +1,83 @@
+#ifndef BRANCHUNIT_H
+#define BRANCHUNIT_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for branch prediction unit with BTB and return address stack
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "BranchPredictor.h"
+#include "Retired.h"
+
+using namespace std;
+
+class BranchUnit {
+
+    private:
+
+        // direction predictors evaluated side by side, the first one drives the timing model
+        vector<BranchPredictor*> predictors;
+
+        // direct-mapped branch target buffer
+        static const unsigned int btb_bits = 9;
+        vector<uint64_t> btb_pc;
+        vector<uint64_t> btb_target;
+
+        // circular return address stack
+        static const unsigned int ras_size = 16;
+        vector<uint64_t> ras;
+        unsigned int ras_top;
+        unsigned int ras_count;
+
+        // statistics
+        uint64_t branches;
+        uint64_t taken_branches;
+        vector<uint64_t> mispredicts;
+        uint64_t target_mispredicts;
+        uint64_t jumps;
+        uint64_t jump_mispredicts;
+        uint64_t returns;
+        uint64_t return_mispredicts;
+        uint64_t indirects;
+        uint64_t indirect_mispredicts;
+
+        // per static branch statistics
+        struct BranchStats
+        {
+            uint64_t count;
+            uint64_t taken;
+            vector<uint64_t> mispredicts;
+        };
+        unordered_map<uint64_t,BranchStats> branch_stats;
+
+        // return BTB target for pc, or 0 on a miss
+        uint64_t btbLookup(uint64_t pc);
+        void btbUpdate(uint64_t pc, uint64_t target);
+
+        // return address stack operations, pop returns 0 when empty
+        void rasPush(uint64_t address);
+        uint64_t rasPop();
+
+    public:
+
+        // Constructor
+        BranchUnit();
+
+        // add a direction predictor
+        void addPredictor(BranchPredictor* predictor);
+
+        // predict and train on a retired instruction, returning true if the first predictor
+        // mispredicted its direction or the target was not predicted
+        bool resolve(const RetiredIns& rec);
+
+        // print accuracy per predictor and for the most mispredicted branches
+        void printStats();
+
+        // destructor
+        ~BranchUnit();
+};
+
+#endif
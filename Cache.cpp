@@ -0,0 +1,416 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for cache model
+**************************************************************** */
+
+#include "Cache.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+
+// Constructor
+Cache::Cache(string name, unsigned int size, unsigned int assoc, unsigned int line_size,
+             Policy policy, bool write_back, unsigned int hit_latency)
+{
+    // configuration
+    this->name = name;
+    this->size = size;
+    this->assoc = assoc;
+    this->line_size = line_size;
+    this->policy = policy;
+    this->write_back = write_back;
+    this->hit_latency = hit_latency;
+    sets = size / (assoc * line_size);
+    line_bits = 0;
+    while ((1u << line_bits) < line_size) line_bits++;
+
+    // next level
+    next = NULL;
+    memory_latency = 100;
+    dram = NULL;
+
+    // tag array
+    lines.assign(sets * assoc, UINT64_MAX);
+    dirty.assign(sets * assoc, 0);
+    stamps.assign(sets * assoc, 0);
+    plru.assign(sets, 0);
+    prefetched.assign(sets * assoc, 0);
+    ready.assign(sets * assoc, 0);
+    clock = 0;
+    rng = 0x9e3779b97f4a7c15ULL;
+    last_line = UINT64_MAX;
+    last_index = 0;
+
+    // no prefetcher
+    prefetcher = NULL;
+    now = 0;
+
+    // statistics
+    accesses = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    writebacks = 0;
+    prefetches = 0;
+    useful = 0;
+    late = 0;
+    useless = 0;
+}
+
+// create a cache from "size:assoc:line[:lru|plru|random[:wb|wt]]", NULL if invalid
+Cache* Cache::create(string name, string spec, unsigned int hit_latency)
+{
+    vector<string> fields;
+    string field;
+    stringstream ss(spec);
+    while (getline(ss, field, ':')) fields.push_back(field);
+
+    if (fields.size() < 3 || fields.size() > 5)
+    {
+        cout << "Invalid cache specification: " << spec << endl;
+        return NULL;
+    }
+
+    // size in bytes with an optional k suffix
+    char* end;
+    unsigned long size = strtoul(fields[0].c_str(), &end, 10);
+    if (*end == 'k' || *end == 'K') size *= 1024;
+    unsigned long assoc = strtoul(fields[1].c_str(), NULL, 10);
+    unsigned long line = strtoul(fields[2].c_str(), NULL, 10);
+
+    Policy policy = policy_lru;
+    if (fields.size() > 3)
+    {
+        if (fields[3] == "plru") policy = policy_plru;
+        else if (fields[3] == "random") policy = policy_random;
+        else if (fields[3] != "lru")
+        {
+            cout << "Invalid replacement policy: " << fields[3] << endl;
+            return NULL;
+        }
+    }
+
+    bool write_back = true;
+    if (fields.size() > 4)
+    {
+        if (fields[4] == "wt") write_back = false;
+        else if (fields[4] != "wb")
+        {
+            cout << "Invalid write policy: " << fields[4] << endl;
+            return NULL;
+        }
+    }
+
+    // line size, associativity and set count must be powers of two
+    if (line == 0 || assoc == 0 || assoc > 64 || (line & (line - 1)) != 0 || (assoc & (assoc - 1)) != 0 ||
+        size < assoc * line || ((size / (assoc * line)) & (size / (assoc * line) - 1)) != 0)
+    {
+        cout << "Invalid cache geometry: " << spec << endl;
+        return NULL;
+    }
+
+    return new Cache(name, size, assoc, line, policy, write_back, hit_latency);
+}
+
+// set next level
+void Cache::setNext(Cache* next)
+{
+    this->next = next;
+}
+
+// set memory latency when there is no next level
+void Cache::setMemoryLatency(unsigned int memory_latency)
+{
+    this->memory_latency = memory_latency;
+}
+
+// set DRAM model used in place of the memory latency
+void Cache::setDram(Dram* dram)
+{
+    this->dram = dram;
+}
+
+// attach a prefetcher
+void Cache::setPrefetcher(Prefetcher* prefetcher)
+{
+    this->prefetcher = prefetcher;
+    prefetcher->setLineSize(line_size);
+}
+
+// set current time in cycles
+void Cache::setTime(uint64_t now)
+{
+    this->now = now;
+}
+
+// update replacement state on a use of a way
+void Cache::touch(unsigned int set, unsigned int way)
+{
+    if (policy == policy_lru)
+    {
+        stamps[set * assoc + way] = ++clock;
+    }
+    else if (policy == policy_plru)
+    {
+        // point each node on the path away from way
+        unsigned int node = 1;
+        for (unsigned int bit = assoc >> 1; bit != 0; bit >>= 1)
+        {
+            if (way & bit)
+            {
+                plru[set] &= ~(1ULL << node);
+                node = node * 2 + 1;
+            }
+            else
+            {
+                plru[set] |= (1ULL << node);
+                node = node * 2;
+            }
+        }
+    }
+}
+
+// choose the way to replace in a set
+unsigned int Cache::victim(unsigned int set)
+{
+    unsigned int base = set * assoc;
+
+    // fill invalid ways first
+    for (unsigned int way = 0; way < assoc; way++)
+    {
+        if (lines[base + way] == UINT64_MAX) return way;
+    }
+
+    if (policy == policy_lru)
+    {
+        unsigned int way = 0;
+        for (unsigned int i = 1; i < assoc; i++)
+        {
+            if (stamps[base + i] < stamps[base + way]) way = i;
+        }
+        return way;
+    }
+    else if (policy == policy_plru)
+    {
+        // follow the tree bits
+        unsigned int node = 1;
+        unsigned int way = 0;
+        for (unsigned int bit = assoc >> 1; bit != 0; bit >>= 1)
+        {
+            if ((plru[set] >> node) & 1)
+            {
+                way |= bit;
+                node = node * 2 + 1;
+            }
+            else
+            {
+                node = node * 2;
+            }
+        }
+        return way;
+    }
+
+    // xorshift random
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng % assoc;
+}
+
+// cycles to reach the next level or memory
+unsigned int Cache::nextAccess(uint64_t address, bool write)
+{
+    if (next == NULL) return dram != NULL ? dram->access(address, write, now) : memory_latency;
+    next->now = now;
+    return next->hit_latency + next->access(address, write);
+}
+
+// fill lines requested by the prefetcher
+void Cache::prefetch(uint64_t pc, uint64_t address, bool trigger)
+{
+    candidates.clear();
+    prefetcher->observe(pc, address, trigger, candidates);
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        uint64_t line = candidates[i];
+        unsigned int set = line & (sets - 1);
+        unsigned int base = set * assoc;
+
+        // skip lines already present
+        bool present = false;
+        for (unsigned int way = 0; way < assoc && !present; way++)
+        {
+            present = lines[base + way] == line;
+        }
+        if (present) continue;
+
+        // replace a line, counted as an eviction but not as a demand access
+        unsigned int way = victim(set);
+        unsigned int index = base + way;
+        if (lines[index] != UINT64_MAX)
+        {
+            evictions++;
+            if (prefetched[index]) useless++;
+            if (dirty[index])
+            {
+                writebacks++;
+                nextAccess(lines[index] << line_bits, true);
+            }
+        }
+        // touching a way changes the recency order of its set, so the next demand access
+        // to the last line must take the full path and touch it again
+        if ((last_line & (sets - 1)) == set) last_line = UINT64_MAX;
+
+        prefetches++;
+        lines[index] = line;
+        dirty[index] = 0;
+        prefetched[index] = 1;
+        ready[index] = now + nextAccess(line << line_bits, false);
+        touch(set, way);
+    }
+}
+
+// access an address, returning cycles beyond the hit latency
+unsigned int Cache::access(uint64_t address, bool write, uint64_t pc)
+{
+    uint64_t line = address >> line_bits;
+    accesses++;
+
+    // repeated access to the most recently used line
+    if (line == last_line)
+    {
+        hits++;
+        if (write)
+        {
+            if (write_back) dirty[last_index] = 1;
+            else nextAccess(address, true);
+        }
+        if (prefetcher != NULL) prefetch(pc, address, false);
+        return 0;
+    }
+
+    unsigned int set = line & (sets - 1);
+    unsigned int base = set * assoc;
+
+    // tag lookup
+    for (unsigned int way = 0; way < assoc; way++)
+    {
+        if (lines[base + way] == line)
+        {
+            hits++;
+            touch(set, way);
+            last_line = line;
+            last_index = base + way;
+            if (write)
+            {
+                if (write_back) dirty[base + way] = 1;
+                else nextAccess(address, true);
+            }
+
+            // first use of a prefetched line, waiting if the fill is still in flight
+            unsigned int latency = 0;
+            bool first_use = prefetched[base + way] != 0;
+            if (first_use)
+            {
+                prefetched[base + way] = 0;
+                useful++;
+                if (ready[base + way] > now)
+                {
+                    late++;
+                    latency = ready[base + way] - now;
+                }
+            }
+            if (prefetcher != NULL) prefetch(pc, address, first_use);
+            return latency;
+        }
+    }
+
+    misses++;
+
+    // write-through caches do not allocate on a write miss, the write buffer hides it
+    if (write && !write_back)
+    {
+        nextAccess(address, true);
+        if (prefetcher != NULL) prefetch(pc, address, true);
+        return 0;
+    }
+
+    // replace a line, writing back the victim if dirty
+    unsigned int way = victim(set);
+    unsigned int index = base + way;
+    if (lines[index] != UINT64_MAX)
+    {
+        evictions++;
+        if (prefetched[index]) useless++;
+        if (dirty[index])
+        {
+            writebacks++;
+            nextAccess(lines[index] << line_bits, true);
+        }
+    }
+
+    // fill from the next level
+    unsigned int latency = nextAccess(address, false);
+    lines[index] = line;
+    dirty[index] = write ? 1 : 0;
+    prefetched[index] = 0;
+    touch(set, way);
+    last_line = line;
+    last_index = index;
+
+    if (prefetcher != NULL) prefetch(pc, address, true);
+    return latency;
+}
+
+// return line size in bytes
+unsigned int Cache::getLineSize()
+{
+    return line_size;
+}
+
+// return number of accesses
+uint64_t Cache::getAccesses()
+{
+    return accesses;
+}
+
+// return number of misses
+uint64_t Cache::getMisses()
+{
+    return misses;
+}
+
+// print hit, miss and eviction counts
+void Cache::printStats()
+{
+    cout << name << ": " << dec;
+    if (size % 1024 == 0) cout << size / 1024 << "KB, ";
+    else cout << size << "B, ";
+    cout << assoc << "-way, " << line_size << "B lines, "
+         << (policy == policy_lru ? "LRU" : policy == policy_plru ? "PLRU" : "random") << ", "
+         << (write_back ? "write-back" : "write-through") << endl;
+    cout << name << " accesses: " << accesses << ", hits: " << hits << ", misses: " << misses
+         << ", evictions: " << evictions << ", writebacks: " << writebacks;
+    if (accesses) cout << ", miss rate: " << fixed << setprecision(2) << 100.0 * misses / accesses << "%";
+    cout << defaultfloat << setprecision(6) << endl;
+
+    // coverage is misses removed, accuracy is prefetches used, timeliness is uses not waiting on the fill
+    if (prefetcher != NULL)
+    {
+        cout << name << " prefetcher " << prefetcher->getName() << ": prefetches: " << prefetches
+             << ", useful: " << useful << ", late: " << late << ", useless: " << useless << endl;
+        cout << name << " prefetch coverage: " << fixed << setprecision(2)
+             << (useful + misses ? 100.0 * useful / (useful + misses) : 0.0) << "%, accuracy: "
+             << (prefetches ? 100.0 * useful / prefetches : 0.0) << "%, timeliness: "
+             << (useful ? 100.0 * (useful - late) / useful : 0.0) << "%"
+             << defaultfloat << setprecision(6) << endl;
+    }
+}
+
+// destructor
+Cache::~Cache()
+{
+    delete prefetcher;
+}
@@ -0,0 +1,127 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for cache model
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "Prefetcher.h"
+#include "Dram.h"
+
+using namespace std;
+
+class Cache {
+
+    public:
+
+        // replacement policies
+        enum Policy
+        {
+            policy_lru,
+            policy_plru,
+            policy_random
+        };
+
+    private:
+
+        // configuration
+        string name;
+        unsigned int size;
+        unsigned int assoc;
+        unsigned int line_size;
+        unsigned int sets;
+        unsigned int line_bits;
+        Policy policy;
+        bool write_back;            // write-back with write-allocate, or write-through without
+        unsigned int hit_latency;   // cycles seen by the level above
+
+        // next level, or memory when NULL
+        Cache* next;
+        unsigned int memory_latency;
+        Dram* dram;                 // memory model, fixed latency when NULL
+
+        // tag array, indexed by set * assoc + way
+        vector<uint64_t> lines;     // line address, UINT64_MAX when invalid
+        vector<uint8_t> dirty;
+        vector<uint64_t> stamps;    // LRU last use
+        vector<uint64_t> plru;      // PLRU tree bits per set
+        vector<uint8_t> prefetched; // filled by the prefetcher and not yet used
+        vector<uint64_t> ready;     // time a prefetched line arrives
+        uint64_t clock;
+        uint64_t rng;
+
+        // most recently used line, checked before the tag array
+        uint64_t last_line;
+        unsigned int last_index;
+
+        // prefetcher, NULL when disabled
+        Prefetcher* prefetcher;
+        vector<uint64_t> candidates;
+        uint64_t now;
+
+        // statistics
+        uint64_t accesses;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t writebacks;
+        uint64_t prefetches;        // lines filled by the prefetcher
+        uint64_t useful;            // prefetched lines used by a demand access
+        uint64_t late;              // used before the fill completed
+        uint64_t useless;           // evicted without use
+
+        // update replacement state on a use of a way
+        void touch(unsigned int set, unsigned int way);
+
+        // choose the way to replace in a set
+        unsigned int victim(unsigned int set);
+
+        // cycles to reach the next level or memory
+        unsigned int nextAccess(uint64_t address, bool write);
+
+        // fill lines requested by the prefetcher
+        void prefetch(uint64_t pc, uint64_t address, bool trigger);
+
+    public:
+
+        // Constructor
+        Cache(string name, unsigned int size, unsigned int assoc, unsigned int line_size,
+              Policy policy, bool write_back, unsigned int hit_latency);
+
+        // create a cache from "size:assoc:line[:lru|plru|random[:wb|wt]]", NULL if invalid
+        static Cache* create(string name, string spec, unsigned int hit_latency);
+
+        // set next level, or memory latency when there is none
+        void setNext(Cache* next);
+        void setMemoryLatency(unsigned int memory_latency);
+        void setDram(Dram* dram);
+
+        // attach a prefetcher, deleted with the cache
+        void setPrefetcher(Prefetcher* prefetcher);
+
+        // set current time in cycles, used for prefetch timeliness
+        void setTime(uint64_t now);
+
+        // access an address from the instruction at pc, returning cycles beyond the hit latency
+        unsigned int access(uint64_t address, bool write, uint64_t pc = 0);
+
+        // return line size in bytes
+        unsigned int getLineSize();
+
+        // return statistics
+        uint64_t getAccesses();
+        uint64_t getMisses();
+
+        // print hit, miss and eviction counts
+        void printStats();
+
+        // destructor
+        ~Cache();
+};
+
+#endif
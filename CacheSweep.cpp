@@ -0,0 +1,150 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for single-pass multi-configuration cache sweep
+**************************************************************** */
+
+#include "CacheSweep.h"
+#include <iostream>
+#include <iomanip>
+
+// Constructor
+CacheSweep::CacheSweep(char stream)
+{
+    fetches = stream == 'i' || stream == 'u';
+    data = stream == 'd' || stream == 'u';
+    accesses = 0;
+
+    // LRU stacks for 32, 64 and 128 byte lines and every set count in the size range
+    for (unsigned int line_bits = 5; line_bits <= 7; line_bits++)
+    {
+        for (unsigned int sets = 1; sets * (1u << line_bits) <= max_size; sets *= 2)
+        {
+            Stack stack;
+            stack.line_bits = line_bits;
+            stack.sets = sets;
+            stack.lines.assign(sets * max_assoc, UINT64_MAX);
+            stack.distance.assign(max_assoc + 1, 0);
+            stacks.push_back(stack);
+        }
+    }
+
+    // PLRU and random caches with 64 byte lines
+    for (unsigned int size = 4096; size <= max_size; size *= 2)
+    {
+        for (unsigned int assoc = 2; assoc <= max_assoc; assoc *= 2)
+        {
+            for (int policy = Cache::policy_plru; policy <= Cache::policy_random; policy++)
+            {
+                caches.push_back(new Cache("sweep", size, assoc, 64, (Cache::Policy) policy, true, 0));
+                cache_size.push_back(size);
+                cache_assoc.push_back(assoc);
+                cache_policy.push_back((Cache::Policy) policy);
+            }
+        }
+    }
+}
+
+// record an access in every configuration
+void CacheSweep::access(uint64_t address, bool fetch)
+{
+    if (fetch ? !fetches : !data) return;
+    accesses++;
+
+    for (size_t i = 0; i < stacks.size(); i++)
+    {
+        Stack& stack = stacks[i];
+        uint64_t line = address >> stack.line_bits;
+        uint64_t* set = &stack.lines[(line & (stack.sets - 1)) * max_assoc];
+
+        // find the stack distance, then move the line to the top
+        unsigned int depth = 0;
+        while (depth < max_assoc && set[depth] != line) depth++;
+        stack.distance[depth]++;
+        for (unsigned int j = (depth == max_assoc ? max_assoc - 1 : depth); j > 0; j--)
+        {
+            set[j] = set[j - 1];
+        }
+        set[0] = line;
+    }
+
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        caches[i]->access(address, false);
+    }
+}
+
+// return misses of an LRU cache from the stack distances
+uint64_t CacheSweep::lruMisses(unsigned int size, unsigned int assoc, unsigned int line_size)
+{
+    for (size_t i = 0; i < stacks.size(); i++)
+    {
+        if ((1u << stacks[i].line_bits) == line_size && stacks[i].sets * assoc * line_size == size)
+        {
+            // an access misses when its stack distance is at least the associativity
+            uint64_t misses = 0;
+            for (unsigned int depth = assoc; depth <= max_assoc; depth++) misses += stacks[i].distance[depth];
+            return misses;
+        }
+    }
+    return UINT64_MAX;
+}
+
+// print miss rate tables
+void CacheSweep::printStats()
+{
+    cout << "Cache sweep: " << dec << accesses << " accesses, miss rate % by size and associativity" << endl;
+    if (accesses == 0) return;
+    cout << fixed << setprecision(2);
+
+    // LRU tables, one per line size
+    for (unsigned int line_size = 32; line_size <= 128; line_size *= 2)
+    {
+        cout << "LRU, " << line_size << "B lines" << endl;
+        cout << setfill(' ') << setw(8) << "size";
+        for (unsigned int assoc = 1; assoc <= max_assoc; assoc *= 2) cout << setw(8) << assoc;
+        cout << endl;
+        for (unsigned int size = min_size; size <= max_size; size *= 2)
+        {
+            cout << setw(6) << size / 1024 << "KB";
+            for (unsigned int assoc = 1; assoc <= max_assoc; assoc *= 2)
+            {
+                uint64_t misses = lruMisses(size, assoc, line_size);
+                if (misses == UINT64_MAX) cout << setw(8) << "-";
+                else cout << setw(8) << 100.0 * misses / accesses;
+            }
+            cout << endl;
+        }
+    }
+
+    // PLRU and random tables
+    for (int policy = Cache::policy_plru; policy <= Cache::policy_random; policy++)
+    {
+        cout << (policy == Cache::policy_plru ? "PLRU" : "Random") << ", 64B lines" << endl;
+        cout << setfill(' ') << setw(8) << "size";
+        for (unsigned int assoc = 2; assoc <= max_assoc; assoc *= 2) cout << setw(8) << assoc;
+        cout << endl;
+        for (unsigned int size = 4096; size <= max_size; size *= 2)
+        {
+            cout << setw(6) << size / 1024 << "KB";
+            for (size_t i = 0; i < caches.size(); i++)
+            {
+                if (cache_size[i] == size && cache_policy[i] == policy)
+                {
+                    cout << setw(8) << 100.0 * caches[i]->getMisses() / accesses;
+                }
+            }
+            cout << endl;
+        }
+    }
+
+    cout << defaultfloat << setprecision(6);
+}
+
+// destructor
+CacheSweep::~CacheSweep()
+{
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        delete caches[i];
+    }
+}
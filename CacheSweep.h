@@ -0,0 +1,64 @@
+#ifndef CACHESWEEP_H
+#define CACHESWEEP_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for single-pass multi-configuration cache sweep
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include "Cache.h"
+
+using namespace std;
+
+class CacheSweep {
+
+    private:
+
+        // address streams included in the sweep
+        bool fetches;
+        bool data;
+
+        // sweep ranges
+        static const unsigned int min_size = 1024;
+        static const unsigned int max_size = 1024 * 1024;
+        static const unsigned int max_assoc = 16;
+
+        // LRU stack per line size and set count, each set holds max_assoc lines, most recent first
+        struct Stack
+        {
+            unsigned int line_bits;
+            unsigned int sets;
+            vector<uint64_t> lines;
+            vector<uint64_t> distance;  // accesses by stack distance, max_assoc for misses
+        };
+        vector<Stack> stacks;
+
+        // parallel tag arrays for policies without the stack property
+        vector<Cache*> caches;
+        vector<unsigned int> cache_size;
+        vector<unsigned int> cache_assoc;
+        vector<Cache::Policy> cache_policy;
+
+        uint64_t accesses;
+
+        // return misses of an LRU cache from the stack distances
+        uint64_t lruMisses(unsigned int size, unsigned int assoc, unsigned int line_size);
+
+    public:
+
+        // Constructor, stream is 'i' (fetches), 'd' (loads and stores) or 'u' (both)
+        CacheSweep(char stream);
+
+        // record an access in every configuration
+        void access(uint64_t address, bool fetch);
+
+        // print miss rate tables
+        void printStats();
+
+        // destructor
+        ~CacheSweep();
+};
+
+#endif
@@ -0,0 +1,80 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for core local interruptor (msip, mtimecmp and mtime)
+**************************************************************** */
+
+#include "Clint.h"
+
+// Constructor
+Clint::Clint(uint64_t base, unsigned int ratio)
+{
+    this->base = base;
+    this->ratio = ratio == 0 ? 1 : ratio;
+    msip = 0;
+    mtimecmp = UINT64_MAX;
+    mtime_base = 0;
+}
+
+// read the doubleword containing address at the given tick
+uint64_t Clint::read(uint64_t address, uint64_t ticks)
+{
+    uint64_t offset = (address - base) & ~(uint64_t)7;
+    if (offset == msip_offset) return msip;
+    if (offset == mtimecmp_offset) return mtimecmp;
+    if (offset == mtime_offset) return getMtime(ticks);
+    return 0;
+}
+
+// write the doubleword containing address at the given tick, mask selects bytes
+void Clint::write(uint64_t address, uint64_t data, uint64_t mask, uint64_t ticks)
+{
+    uint64_t offset = (address - base) & ~(uint64_t)7;
+    if (offset == msip_offset)
+    {
+        msip = ((msip & ~mask) | (data & mask)) & 1;
+    }
+    else if (offset == mtimecmp_offset)
+    {
+        mtimecmp = (mtimecmp & ~mask) | (data & mask);
+    }
+    else if (offset == mtime_offset)
+    {
+        uint64_t mtime = (getMtime(ticks) & ~mask) | (data & mask);
+        mtime_base = mtime - ticks / ratio;
+    }
+}
+
+// return mtime at the given tick
+uint64_t Clint::getMtime(uint64_t ticks)
+{
+    return mtime_base + ticks / ratio;
+}
+
+// return true while mtime >= mtimecmp
+bool Clint::timerPending(uint64_t ticks)
+{
+    return getMtime(ticks) >= mtimecmp;
+}
+
+// return true while msip is set
+bool Clint::softwarePending()
+{
+    return msip != 0;
+}
+
+// return the tick at which the timer fires, UINT64_MAX if pending already or never
+uint64_t Clint::nextExpiry(uint64_t ticks)
+{
+    if (timerPending(ticks)) return UINT64_MAX;
+
+    // first tick with mtime_base + tick / ratio >= mtimecmp
+    uint64_t target = mtimecmp - mtime_base;
+    if (target > UINT64_MAX / ratio) return UINT64_MAX;
+    return target * ratio;
+}
+
+// destructor
+Clint::~Clint()
+{
+
+}
@@ -0,0 +1,62 @@
+#ifndef CLINT_H
+#define CLINT_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for core local interruptor (msip, mtimecmp and mtime)
+**************************************************************** */
+
+#include <cstdint>
+
+using namespace std;
+
+class Clint {
+
+    private:
+
+        // register layout relative to base
+        static const uint64_t msip_offset = 0x0000;
+        static const uint64_t mtimecmp_offset = 0x4000;
+        static const uint64_t mtime_offset = 0xbff8;
+        static const uint64_t size = 0x10000;
+
+        uint64_t base;
+        unsigned int ratio;         // ticks per mtime increment
+
+        // registers, mtime is derived from ticks
+        uint32_t msip;
+        uint64_t mtimecmp;
+        uint64_t mtime_base;        // mtime at tick 0, adjusted by mtime writes
+
+    public:
+
+        // Constructor
+        Clint(uint64_t base, unsigned int ratio);
+
+        // return true if address falls in the register block
+        bool contains(uint64_t address)
+        {
+            return address - base < size;
+        }
+
+        // read the doubleword containing address at the given tick
+        uint64_t read(uint64_t address, uint64_t ticks);
+
+        // write the doubleword containing address at the given tick, mask selects bytes
+        void write(uint64_t address, uint64_t data, uint64_t mask, uint64_t ticks);
+
+        // return mtime at the given tick
+        uint64_t getMtime(uint64_t ticks);
+
+        // return interrupt pending levels for mip.MTIP and mip.MSIP
+        bool timerPending(uint64_t ticks);
+        bool softwarePending();
+
+        // return the tick at which the timer fires, UINT64_MAX if pending already or never
+        uint64_t nextExpiry(uint64_t ticks);
+
+        // destructor
+        ~Clint();
+};
+
+#endif
@@ -0,0 +1,157 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for analytical cycle estimate from instruction mix
+**************************************************************** */
+
+#include "CostModel.h"
+#include "TimingModel.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+// Constructor, every instruction costs one cycle
+CostModel::CostModel(const vector<string>& names)
+{
+    this->names = names;
+    costs.assign(names.size(), 1);
+    redirect_cost = 0;
+    trap_cost = 0;
+
+    mix.assign(names.size(), 0);
+    redirects = 0;
+    traps = 0;
+    miss_cycles = 0;
+}
+
+// load "name cycles" lines, NULL if the file cannot be read or has unknown names
+// default and class entries (load, store, branch, jump, csr, system) apply before mnemonics,
+// taken and trap set the cost of a taken transfer and of a trap
+CostModel* CostModel::load(string file_name, const vector<string>& names)
+{
+    ifstream input_file(file_name);
+    if (!input_file.is_open())
+    {
+        cout << "Failed to open cost file: " << file_name << endl;
+        return NULL;
+    }
+
+    CostModel* model = new CostModel(names);
+    vector<pair<string, uint32_t> > entries;
+    string line;
+    unsigned int line_count = 0;
+    while (getline(input_file, line))
+    {
+        line_count++;
+        line = line.substr(0, line.find('#'));
+        stringstream ss(line);
+        string name;
+        uint32_t cycles;
+        if (!(ss >> name)) continue;
+        if (!(ss >> cycles))
+        {
+            cout << "Cost file line " << dec << line_count << " has no cycle count" << endl;
+            delete model;
+            return NULL;
+        }
+        entries.push_back(make_pair(name, cycles));
+    }
+
+    // apply in order of increasing specificity
+    for (unsigned int pass = 0; pass < 3; pass++)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const string& name = entries[i].first;
+            uint32_t cycles = entries[i].second;
+            bool is_class = name == "load" || name == "store" || name == "branch" ||
+                            name == "jump" || name == "csr" || name == "system";
+            if (pass == 0 && name == "default")
+            {
+                model->costs.assign(names.size(), cycles);
+            }
+            else if (pass == 1 && is_class)
+            {
+                for (size_t code = 0; code < names.size(); code++)
+                {
+                    Ins ins = (Ins)code;
+                    if ((name == "load" && TimingModel::isLoad(ins)) ||
+                        (name == "store" && TimingModel::isStore(ins)) ||
+                        (name == "branch" && TimingModel::isBranch(ins)) ||
+                        (name == "jump" && (ins == ins_jal || ins == ins_jalr)) ||
+                        (name == "csr" && TimingModel::isCsr(ins)) ||
+                        (name == "system" && TimingModel::isSystem(ins)))
+                        model->costs[code] = cycles;
+                }
+            }
+            else if (pass == 2 && name == "taken")
+            {
+                model->redirect_cost = cycles;
+            }
+            else if (pass == 2 && name == "trap")
+            {
+                model->trap_cost = cycles;
+            }
+            else if (pass == 2 && name != "default" && !is_class)
+            {
+                size_t code = 0;
+                while (code < names.size() && names[code] != name) code++;
+                if (code == names.size())
+                {
+                    cout << "Unknown instruction in cost file: " << name << endl;
+                    delete model;
+                    return NULL;
+                }
+                model->costs[code] = cycles;
+            }
+        }
+    }
+
+    return model;
+}
+
+// return estimated cycles for the instructions counted so far
+uint64_t CostModel::getCycles()
+{
+    uint64_t cycles = redirects * redirect_cost + traps * trap_cost + miss_cycles;
+    for (size_t code = 0; code < mix.size(); code++) cycles += mix[code] * costs[code];
+    return cycles;
+}
+
+// print instruction mix and cycle breakdown
+void CostModel::printStats()
+{
+    uint64_t instructions = 0;
+    for (size_t code = 0; code < mix.size(); code++) instructions += mix[code];
+    uint64_t cycles = getCycles();
+
+    cout << "Cost model cycles: " << dec << cycles;
+    if (instructions) cout << ", CPI: " << (double)cycles / instructions;
+    cout << endl;
+    cout << "Cost model taken transfers: " << redirects << " (" << redirects * redirect_cost << " cycles), traps: "
+         << traps << " (" << traps * trap_cost << " cycles), cache miss cycles: " << miss_cycles << endl;
+
+    // mix, most frequent first
+    vector<pair<uint64_t, size_t> > order;
+    for (size_t code = 0; code < mix.size(); code++)
+    {
+        if (mix[code]) order.push_back(make_pair(mix[code], code));
+    }
+    sort(order.rbegin(), order.rend());
+    cout << setfill(' ') << "  instruction      count     cost   cycles%" << endl;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        size_t code = order[i].second;
+        cout << "  " << left << setw(10) << names[code] << right << setw(12) << mix[code]
+             << setw(8) << costs[code] << setw(9) << fixed << setprecision(2)
+             << (cycles ? 100.0 * mix[code] * costs[code] / cycles : 0.0) << "%"
+             << defaultfloat << setprecision(6) << endl;
+    }
+}
+
+// destructor
+CostModel::~CostModel()
+{
+
+}
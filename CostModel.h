@@ -0,0 +1,62 @@
+#ifndef COSTMODEL_H
+#define COSTMODEL_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for analytical cycle estimate from instruction mix
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "Instruction.h"
+
+using namespace std;
+using namespace RV64I;
+
+class CostModel {
+
+    private:
+
+        // instruction names and cycles indexed by code
+        vector<string> names;
+        vector<uint32_t> costs;
+
+        // cycles added per event
+        uint32_t redirect_cost;     // taken branch or jump
+        uint32_t trap_cost;
+
+        // counters incremented from the execute path
+        vector<uint64_t> mix;
+        uint64_t redirects;
+        uint64_t traps;
+        uint64_t miss_cycles;       // penalties reported by the cache models
+
+    public:
+
+        // Constructor, every instruction costs one cycle
+        CostModel(const vector<string>& names);
+
+        // load "name cycles" lines, NULL if the file cannot be read or has unknown names
+        static CostModel* load(string file_name, const vector<string>& names);
+
+        // count a retired instruction, inline to keep the execute path cheap
+        void count(Ins code, bool redirect, bool trap, unsigned int penalty)
+        {
+            mix[code]++;
+            redirects += redirect;
+            traps += trap;
+            miss_cycles += penalty;
+        }
+
+        // return estimated cycles for the instructions counted so far
+        uint64_t getCycles();
+
+        // print instruction mix and cycle breakdown
+        void printStats();
+
+        // destructor
+        ~CostModel();
+};
+
+#endif
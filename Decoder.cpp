@@ -4,6 +4,7 @@
 **************************************************************** */
 
 #include "Decoder.h"
+#include "Isa.h"
 #include <iostream>
 #include <iomanip>
 
@@ -19,9 +20,11 @@ Decoder::Decoder(bool verbose)
     rd = 0;
     rs1 = 0;
     rs2 = 0;
+    rs3 = 0;
     funct3 = 0;
     funct7 = 0;
     imm = 0;
+    length = 4;
 
     // instruction properties
     code = ins_default;
@@ -87,13 +90,232 @@ Decoder::Decoder(bool verbose)
         "csrrc",
         "csrrwi",
         "csrrsi",
-        "csrrci"
+        "csrrci",
+        "wfi",
+        "sret",
+        "sfence.vma",
+        "mul",
+        "mulh",
+        "mulhsu",
+        "mulhu",
+        "div",
+        "divu",
+        "rem",
+        "remu",
+        "mulw",
+        "divw",
+        "divuw",
+        "remw",
+        "remuw",
+        "lr.w",
+        "sc.w",
+        "amoswap.w",
+        "amoadd.w",
+        "amoxor.w",
+        "amoand.w",
+        "amoor.w",
+        "amomin.w",
+        "amomax.w",
+        "amominu.w",
+        "amomaxu.w",
+        "lr.d",
+        "sc.d",
+        "amoswap.d",
+        "amoadd.d",
+        "amoxor.d",
+        "amoand.d",
+        "amoor.d",
+        "amomin.d",
+        "amomax.d",
+        "amominu.d",
+        "amomaxu.d",
+        "sh1add",
+        "sh2add",
+        "sh3add",
+        "add.uw",
+        "sh1add.uw",
+        "sh2add.uw",
+        "sh3add.uw",
+        "slli.uw",
+        "andn",
+        "orn",
+        "xnor",
+        "clz",
+        "ctz",
+        "cpop",
+        "clzw",
+        "ctzw",
+        "cpopw",
+        "min",
+        "minu",
+        "max",
+        "maxu",
+        "sext.b",
+        "sext.h",
+        "zext.h",
+        "rol",
+        "ror",
+        "rori",
+        "rolw",
+        "rorw",
+        "roriw",
+        "orc.b",
+        "rev8",
+        "bclr",
+        "bclri",
+        "bext",
+        "bexti",
+        "binv",
+        "binvi",
+        "bset",
+        "bseti",
+        "flw",
+        "fsw",
+        "fld",
+        "fsd",
+        "fmadd.s",
+        "fmsub.s",
+        "fnmsub.s",
+        "fnmadd.s",
+        "fadd.s",
+        "fsub.s",
+        "fmul.s",
+        "fdiv.s",
+        "fsqrt.s",
+        "fcvt.w.s",
+        "fcvt.wu.s",
+        "fcvt.l.s",
+        "fcvt.lu.s",
+        "fcvt.s.w",
+        "fcvt.s.wu",
+        "fcvt.s.l",
+        "fcvt.s.lu",
+        "fcvt.s.d",
+        "fsgnj.s",
+        "fsgnjn.s",
+        "fsgnjx.s",
+        "fmin.s",
+        "fmax.s",
+        "feq.s",
+        "flt.s",
+        "fle.s",
+        "fclass.s",
+        "fmv.x.w",
+        "fmv.w.x",
+        "fmadd.d",
+        "fmsub.d",
+        "fnmsub.d",
+        "fnmadd.d",
+        "fadd.d",
+        "fsub.d",
+        "fmul.d",
+        "fdiv.d",
+        "fsqrt.d",
+        "fcvt.w.d",
+        "fcvt.wu.d",
+        "fcvt.l.d",
+        "fcvt.lu.d",
+        "fcvt.d.w",
+        "fcvt.d.wu",
+        "fcvt.d.l",
+        "fcvt.d.lu",
+        "fcvt.d.s",
+        "fsgnj.d",
+        "fsgnjn.d",
+        "fsgnjx.d",
+        "fmin.d",
+        "fmax.d",
+        "feq.d",
+        "flt.d",
+        "fle.d",
+        "fclass.d",
+        "fmv.x.d",
+        "fmv.d.x",
+        "vsetvli",
+        "vsetivli",
+        "vsetvl",
+        "vle8.v",
+        "vle16.v",
+        "vle32.v",
+        "vle64.v",
+        "vlse8.v",
+        "vlse16.v",
+        "vlse32.v",
+        "vlse64.v",
+        "vse8.v",
+        "vse16.v",
+        "vse32.v",
+        "vse64.v",
+        "vsse8.v",
+        "vsse16.v",
+        "vsse32.v",
+        "vsse64.v",
+        "vadd.vv",
+        "vadd.vx",
+        "vadd.vi",
+        "vsub.vv",
+        "vsub.vx",
+        "vrsub.vx",
+        "vrsub.vi",
+        "vminu.vv",
+        "vminu.vx",
+        "vmin.vv",
+        "vmin.vx",
+        "vmaxu.vv",
+        "vmaxu.vx",
+        "vmax.vv",
+        "vmax.vx",
+        "vand.vv",
+        "vand.vx",
+        "vand.vi",
+        "vor.vv",
+        "vor.vx",
+        "vor.vi",
+        "vxor.vv",
+        "vxor.vx",
+        "vxor.vi",
+        "vsll.vv",
+        "vsll.vx",
+        "vsll.vi",
+        "vsrl.vv",
+        "vsrl.vx",
+        "vsrl.vi",
+        "vsra.vv",
+        "vsra.vx",
+        "vsra.vi",
+        "vmul.vv",
+        "vmul.vx",
+        "vmacc.vv",
+        "vmacc.vx",
+        "vmv.v.v",
+        "vmv.v.x",
+        "vmv.v.i",
+        "vmv.x.s",
+        "vmv.s.x",
+        "vredsum.vs",
+        "vredand.vs",
+        "vredor.vs",
+        "vredxor.vs",
+        "vredminu.vs",
+        "vredmin.vs",
+        "vredmaxu.vs",
+        "vredmax.vs"
     };
 }
 
 // decode current instruction and store parts into variables
 void Decoder::decodeIns(uint32_t ins)
 {
+    // compressed instructions are expanded and then decoded as usual
+    length = 4;
+#if ISA_C
+    if ((ins & 0x3) != 0x3)
+    {
+        ins = expandCompressed(ins & 0xffff);
+        length = 2;
+    }
+#endif
+
     // set current instructio
     this->ins = ins;
 
@@ -106,6 +328,9 @@ void Decoder::decodeIns(uint32_t ins)
     // funct7 = ins[31:25]
     funct7 = (ins >> 25) & 0x7f;
 
+    // rs3 = ins[31:27], fused multiply-add only
+    rs3 = (ins >> 27) & 0x1f;
+
     switch(opcode)
     {
         // 0b0000011 => 3
@@ -164,6 +389,10 @@ void Decoder::decodeIns(uint32_t ins)
             break;
         // 0b0010011 => 19
         case 19:
+#if ISA_B
+            // Zba, Zbb and Zbs bit manipulation
+            if (decodeBitmanip()) break;
+#endif
             switch(funct3)
             {
                 // 0b000 => 0
@@ -227,6 +456,10 @@ void Decoder::decodeIns(uint32_t ins)
             break;
         // 0b0011011 => 27
         case 27: 
+#if ISA_B
+            // Zba, Zbb and Zbs bit manipulation
+            if (decodeBitmanip()) break;
+#endif
             switch(funct3)
             {
                 // 0b000 => 0
@@ -286,6 +519,32 @@ void Decoder::decodeIns(uint32_t ins)
             break;
         // 0b0110011 = 51
         case 51:
+#if ISA_B
+            // Zba, Zbb and Zbs bit manipulation
+            if (decodeBitmanip()) break;
+#endif
+            // 0b0000001 => 1, M extension
+            if (funct7 == 1)
+            {
+#if ISA_M
+                switch(funct3)
+                {
+                    case 0: code = ins_mul; break;
+                    case 1: code = ins_mulh; break;
+                    case 2: code = ins_mulhsu; break;
+                    case 3: code = ins_mulhu; break;
+                    case 4: code = ins_div; break;
+                    case 5: code = ins_divu; break;
+                    case 6: code = ins_rem; break;
+                    case 7: code = ins_remu; break;
+                }
+                type = 'R';
+                decodeRType();
+#else
+                resetIns();
+#endif
+                break;
+            }
             switch(funct3)
             {
                 // 0b000 => 0
@@ -350,6 +609,30 @@ void Decoder::decodeIns(uint32_t ins)
             break;
         // 0b0111011 => 59
         case 59: 
+#if ISA_B
+            // Zba, Zbb and Zbs bit manipulation
+            if (decodeBitmanip()) break;
+#endif
+            // 0b0000001 => 1, M extension
+            if (funct7 == 1)
+            {
+#if ISA_M
+                switch(funct3)
+                {
+                    case 0: code = ins_mulw; break;
+                    case 4: code = ins_divw; break;
+                    case 5: code = ins_divuw; break;
+                    case 6: code = ins_remw; break;
+                    case 7: code = ins_remuw; break;
+                    default: code = ins_default; break;
+                }
+                type = 'R';
+                decodeRType();
+#else
+                resetIns();
+#endif
+                break;
+            }
             switch(funct3)
             {
                 // 0b000 => 0
@@ -376,6 +659,122 @@ void Decoder::decodeIns(uint32_t ins)
                     break;
             }
             break;
+#if ISA_A
+        // 0b0101111 => 47, A extension
+        case 47:
+        {
+            // funct5 = ins[31:27], aq and rl in ins[26:25] are ignored with a single hart
+            int first = funct3 == 3 ? ins_lr_d : ins_lr_w;
+            int op;
+            switch(funct7 >> 2)
+            {
+                case 0x02: op = 0; break;   // lr
+                case 0x03: op = 1; break;   // sc
+                case 0x01: op = 2; break;   // amoswap
+                case 0x00: op = 3; break;   // amoadd
+                case 0x04: op = 4; break;   // amoxor
+                case 0x0c: op = 5; break;   // amoand
+                case 0x08: op = 6; break;   // amoor
+                case 0x10: op = 7; break;   // amomin
+                case 0x14: op = 8; break;   // amomax
+                case 0x18: op = 9; break;   // amominu
+                case 0x1c: op = 10; break;  // amomaxu
+                default: op = -1; break;
+            }
+            if ((funct3 != 2 && funct3 != 3) || op < 0 || (op == 0 && ((ins >> 20) & 0x1f) != 0))
+            {
+                resetIns();
+                break;
+            }
+            code = (Ins) (first + op);
+            type = 'R';
+            imm = 0;
+            decodeRType();
+            break;
+        }
+#endif
+        // 0b0000111 => 7, F and D loads, vector loads for the other widths
+        case 7:
+#if ISA_V
+            if (funct3 == 0 || funct3 >= 5)
+            {
+                code = decodeVectorMemory(ins_vle8_v, ins_vlse8_v);
+                break;
+            }
+#endif
+#if ISA_FD
+            if (funct3 == 2 || funct3 == 3)
+            {
+                code = funct3 == 2 ? ins_flw : ins_fld;
+                type = 'I';
+                decodeIType();
+                break;
+            }
+#endif
+            resetIns();
+            break;
+        // 0b0100111 => 39, F and D stores, vector stores for the other widths
+        case 39:
+#if ISA_V
+            if (funct3 == 0 || funct3 >= 5)
+            {
+                code = decodeVectorMemory(ins_vse8_v, ins_vsse8_v);
+                break;
+            }
+#endif
+#if ISA_FD
+            if (funct3 == 2 || funct3 == 3)
+            {
+                code = funct3 == 2 ? ins_fsw : ins_fsd;
+                type = 'S';
+                decodeSType();
+                break;
+            }
+#endif
+            resetIns();
+            break;
+#if ISA_FD
+        // 0b1000011 => 67, 0b1000111 => 71, 0b1001011 => 75, 0b1001111 => 79, fused multiply-add
+        case 67:
+        case 71:
+        case 75:
+        case 79:
+            if ((funct7 & 0x3) > 1)
+            {
+                resetIns();
+                break;
+            }
+            code = (Ins) (ins_fmadd_s + (opcode - 67) / 4);
+            if (funct7 & 0x1) code = (Ins) (code - ins_fmadd_s + ins_fmadd_d);
+            type = 'R';
+            decodeRType();
+            break;
+        // 0b1010011 => 83, other F and D operations
+        case 83:
+            code = decodeFloat();
+            if (code == ins_default)
+            {
+                resetIns();
+                break;
+            }
+            type = 'R';
+            decodeRType();
+            break;
+#endif
+#if ISA_V
+        // 0b1010111 => 87, vector configuration and arithmetic
+        case 87:
+            code = decodeVector();
+            if (code == ins_default)
+            {
+                resetIns();
+                break;
+            }
+            type = 'V';
+            imm = 0;
+            decodeRType();
+            break;
+#endif
         // 0b1100011 => 99
         case 99:
             switch(funct3)
@@ -441,7 +840,16 @@ void Decoder::decodeIns(uint32_t ins)
                     code = ins_ebreak;
                     if (ins >> 20 == 0) code = ins_ecall;
                     if (ins >> 20 == 770) code = ins_mret;
+                    if (ins >> 20 == 261) code = ins_wfi;
+                    if (ins >> 20 == 258) code = ins_sret;
+                    if (ins >> 25 == 9)
+                    {
+                        code = ins_sfence_vma;
+                        type = 'R';
+                        decodeRType();
+                    }
                     break;
+#if ISA_ZICSR
                 // 0b001 => 1
                 case 1:
                     code = ins_csrrw;
@@ -478,7 +886,9 @@ void Decoder::decodeIns(uint32_t ins)
                     type = 'I';
                     decodeIType();
                     break;
+#endif
                 default:
+                    resetIns();
                     break;
             }
             break;
@@ -488,6 +898,526 @@ void Decoder::decodeIns(uint32_t ins)
     }
 }
 
+#if ISA_C
+// expand a 16-bit compressed instruction to its 32-bit equivalent, 0 if illegal
+uint32_t Decoder::expandCompressed(uint16_t ins)
+{
+    // common fields, primed registers map to x8-x15
+    uint32_t op = ins & 0x3;
+    uint32_t funct3 = (ins >> 13) & 0x7;
+    uint32_t rd = (ins >> 7) & 0x1f;
+    uint32_t rs2 = (ins >> 2) & 0x1f;
+    uint32_t rdp = ((ins >> 2) & 0x7) + 8;
+    uint32_t rs1p = ((ins >> 7) & 0x7) + 8;
+    uint32_t bit12 = (ins >> 12) & 0x1;
+
+    // 6-bit immediate ins[12|6:2], sign-extended to 12 bits
+    uint32_t imm6 = (bit12 << 5) | rs2;
+    uint32_t simm6 = bit12 ? (imm6 | 0xfc0) : imm6;
+
+    // scaled unsigned offsets for the word and doubleword loads and stores
+    uint32_t uimm_w = (((ins >> 10) & 0x7) << 3) | (((ins >> 6) & 0x1) << 2) | (((ins >> 5) & 0x1) << 6);
+    uint32_t uimm_d = (((ins >> 10) & 0x7) << 3) | (((ins >> 5) & 0x3) << 6);
+
+    switch (op)
+    {
+        // quadrant 0
+        case 0:
+            switch (funct3)
+            {
+                // c.addi4spn => addi rd', x2, nzuimm
+                case 0:
+                {
+                    uint32_t nzuimm = (((ins >> 11) & 0x3) << 4) | (((ins >> 7) & 0xf) << 6) |
+                                      (((ins >> 6) & 0x1) << 2) | (((ins >> 5) & 0x1) << 3);
+                    if (nzuimm == 0) return 0;
+                    return (nzuimm << 20) | (2 << 15) | (rdp << 7) | 0x13;
+                }
+                // c.fld => fld rd', uimm(rs1')
+                case 1:
+                    return (uimm_d << 20) | (rs1p << 15) | (3 << 12) | (rdp << 7) | 0x07;
+                // c.lw => lw rd', uimm(rs1')
+                case 2:
+                    return (uimm_w << 20) | (rs1p << 15) | (2 << 12) | (rdp << 7) | 0x03;
+                // c.ld => ld rd', uimm(rs1')
+                case 3:
+                    return (uimm_d << 20) | (rs1p << 15) | (3 << 12) | (rdp << 7) | 0x03;
+                // c.fsd => fsd rs2', uimm(rs1')
+                case 5:
+                    return ((uimm_d >> 5) << 25) | (rdp << 20) | (rs1p << 15) | (3 << 12) |
+                           ((uimm_d & 0x1f) << 7) | 0x27;
+                // c.sw => sw rs2', uimm(rs1')
+                case 6:
+                    return ((uimm_w >> 5) << 25) | (rdp << 20) | (rs1p << 15) | (2 << 12) |
+                           ((uimm_w & 0x1f) << 7) | 0x23;
+                // c.sd => sd rs2', uimm(rs1')
+                case 7:
+                    return ((uimm_d >> 5) << 25) | (rdp << 20) | (rs1p << 15) | (3 << 12) |
+                           ((uimm_d & 0x1f) << 7) | 0x23;
+                default:
+                    return 0;
+            }
+
+        // quadrant 1
+        case 1:
+            switch (funct3)
+            {
+                // c.addi => addi rd, rd, imm
+                case 0:
+                    return (simm6 << 20) | (rd << 15) | (rd << 7) | 0x13;
+                // c.addiw => addiw rd, rd, imm
+                case 1:
+                    if (rd == 0) return 0;
+                    return (simm6 << 20) | (rd << 15) | (rd << 7) | 0x1b;
+                // c.li => addi rd, x0, imm
+                case 2:
+                    return (simm6 << 20) | (rd << 7) | 0x13;
+                case 3:
+                    if (rd == 2)
+                    {
+                        // c.addi16sp => addi x2, x2, nzimm
+                        uint32_t nzimm = (bit12 << 9) | (((ins >> 6) & 0x1) << 4) | (((ins >> 5) & 0x1) << 6) |
+                                         (((ins >> 3) & 0x3) << 7) | (((ins >> 2) & 0x1) << 5);
+                        if (nzimm == 0) return 0;
+                        if (bit12) nzimm |= 0xc00;
+                        return (nzimm << 20) | (2 << 15) | (2 << 7) | 0x13;
+                    }
+                    else
+                    {
+                        // c.lui => lui rd, nzimm
+                        if (imm6 == 0) return 0;
+                        uint32_t nzimm = bit12 ? (imm6 | 0xfffc0) : imm6;
+                        return (nzimm << 12) | (rd << 7) | 0x37;
+                    }
+                case 4:
+                    switch ((ins >> 10) & 0x3)
+                    {
+                        // c.srli => srli rd', rd', shamt
+                        case 0:
+                            return (imm6 << 20) | (rs1p << 15) | (5 << 12) | (rs1p << 7) | 0x13;
+                        // c.srai => srai rd', rd', shamt
+                        case 1:
+                            return (0x10 << 26) | (imm6 << 20) | (rs1p << 15) | (5 << 12) | (rs1p << 7) | 0x13;
+                        // c.andi => andi rd', rd', imm
+                        case 2:
+                            return (simm6 << 20) | (rs1p << 15) | (7 << 12) | (rs1p << 7) | 0x13;
+                        // register-register operations on rd' and rs2'
+                        default:
+                        {
+                            uint32_t base = (rdp << 20) | (rs1p << 15) | (rs1p << 7);
+                            switch ((bit12 << 2) | ((ins >> 5) & 0x3))
+                            {
+                                // c.sub
+                                case 0: return (0x20 << 25) | base | 0x33;
+                                // c.xor
+                                case 1: return base | (4 << 12) | 0x33;
+                                // c.or
+                                case 2: return base | (6 << 12) | 0x33;
+                                // c.and
+                                case 3: return base | (7 << 12) | 0x33;
+                                // c.subw
+                                case 4: return (0x20 << 25) | base | 0x3b;
+                                // c.addw
+                                case 5: return base | 0x3b;
+                                default: return 0;
+                            }
+                        }
+                    }
+                // c.j => jal x0, offset
+                case 5:
+                {
+                    uint32_t off = (bit12 << 11) | (((ins >> 11) & 0x1) << 4) | (((ins >> 9) & 0x3) << 8) |
+                                   (((ins >> 8) & 0x1) << 10) | (((ins >> 7) & 0x1) << 6) |
+                                   (((ins >> 6) & 0x1) << 7) | (((ins >> 3) & 0x7) << 1) | (((ins >> 2) & 0x1) << 5);
+                    if (bit12) off |= 0x1ff000;
+                    return (((off >> 20) & 0x1) << 31) | (((off >> 1) & 0x3ff) << 21) |
+                           (((off >> 11) & 0x1) << 20) | (((off >> 12) & 0xff) << 12) | 0x6f;
+                }
+                // c.beqz => beq rs1', x0, offset and c.bnez => bne rs1', x0, offset
+                default:
+                {
+                    uint32_t off = (bit12 << 8) | (((ins >> 10) & 0x3) << 3) | (((ins >> 5) & 0x3) << 6) |
+                                   (((ins >> 3) & 0x3) << 1) | (((ins >> 2) & 0x1) << 5);
+                    if (bit12) off |= 0x1e00;
+                    return (((off >> 12) & 0x1) << 31) | (((off >> 5) & 0x3f) << 25) | (rs1p << 15) |
+                           ((funct3 & 0x1) << 12) | (((off >> 1) & 0xf) << 8) | (((off >> 11) & 0x1) << 7) | 0x63;
+                }
+            }
+
+        // quadrant 2
+        case 2:
+            switch (funct3)
+            {
+                // c.slli => slli rd, rd, shamt
+                case 0:
+                    return (imm6 << 20) | (rd << 15) | (1 << 12) | (rd << 7) | 0x13;
+                // c.fldsp => fld rd, uimm(x2)
+                case 1:
+                {
+                    uint32_t uimm = (bit12 << 5) | (((ins >> 5) & 0x3) << 3) | (((ins >> 2) & 0x7) << 6);
+                    return (uimm << 20) | (2 << 15) | (3 << 12) | (rd << 7) | 0x07;
+                }
+                // c.lwsp => lw rd, uimm(x2)
+                case 2:
+                {
+                    if (rd == 0) return 0;
+                    uint32_t uimm = (bit12 << 5) | (((ins >> 4) & 0x7) << 2) | (((ins >> 2) & 0x3) << 6);
+                    return (uimm << 20) | (2 << 15) | (2 << 12) | (rd << 7) | 0x03;
+                }
+                // c.ldsp => ld rd, uimm(x2)
+                case 3:
+                {
+                    if (rd == 0) return 0;
+                    uint32_t uimm = (bit12 << 5) | (((ins >> 5) & 0x3) << 3) | (((ins >> 2) & 0x7) << 6);
+                    return (uimm << 20) | (2 << 15) | (3 << 12) | (rd << 7) | 0x03;
+                }
+                case 4:
+                    if (bit12 == 0)
+                    {
+                        if (rs2 == 0)
+                        {
+                            // c.jr => jalr x0, 0(rs1)
+                            if (rd == 0) return 0;
+                            return (rd << 15) | 0x67;
+                        }
+                        // c.mv => add rd, x0, rs2
+                        return (rs2 << 20) | (rd << 7) | 0x33;
+                    }
+                    else
+                    {
+                        // c.ebreak
+                        if (rd == 0 && rs2 == 0) return 0x00100073;
+                        // c.jalr => jalr x1, 0(rs1)
+                        if (rs2 == 0) return (rd << 15) | (1 << 7) | 0x67;
+                        // c.add => add rd, rd, rs2
+                        return (rs2 << 20) | (rd << 15) | (rd << 7) | 0x33;
+                    }
+                // c.fsdsp => fsd rs2, uimm(x2)
+                case 5:
+                {
+                    uint32_t uimm = (((ins >> 10) & 0x7) << 3) | (((ins >> 7) & 0x7) << 6);
+                    return ((uimm >> 5) << 25) | (rs2 << 20) | (2 << 15) | (3 << 12) | ((uimm & 0x1f) << 7) | 0x27;
+                }
+                // c.swsp => sw rs2, uimm(x2)
+                case 6:
+                {
+                    uint32_t uimm = (((ins >> 9) & 0xf) << 2) | (((ins >> 7) & 0x3) << 6);
+                    return ((uimm >> 5) << 25) | (rs2 << 20) | (2 << 15) | (2 << 12) | ((uimm & 0x1f) << 7) | 0x23;
+                }
+                // c.sdsp => sd rs2, uimm(x2)
+                case 7:
+                {
+                    uint32_t uimm = (((ins >> 10) & 0x7) << 3) | (((ins >> 7) & 0x7) << 6);
+                    return ((uimm >> 5) << 25) | (rs2 << 20) | (2 << 15) | (3 << 12) | ((uimm & 0x1f) << 7) | 0x23;
+                }
+                default:
+                    return 0;
+            }
+
+        default:
+            return 0;
+    }
+}
+
+#endif
+
+#if ISA_B
+// decode Zba, Zbb and Zbs instructions, returning false if not bit manipulation
+bool Decoder::decodeBitmanip()
+{
+    uint32_t imm12 = ins >> 20;
+    uint8_t funct6 = funct7 >> 1;
+    uint8_t rs2 = (ins >> 20) & 0x1f;
+    Ins match = ins_default;
+
+    // register-register forms
+    type = 'R';
+    switch(opcode)
+    {
+        // 0b0110011 => 51
+        case 51:
+            switch(funct7)
+            {
+                case 0x10:
+                    if (funct3 == 2) match = ins_sh1add;
+                    if (funct3 == 4) match = ins_sh2add;
+                    if (funct3 == 6) match = ins_sh3add;
+                    break;
+                case 0x20:
+                    if (funct3 == 4) match = ins_xnor;
+                    if (funct3 == 6) match = ins_orn;
+                    if (funct3 == 7) match = ins_andn;
+                    break;
+                case 0x05:
+                    if (funct3 == 4) match = ins_min;
+                    if (funct3 == 5) match = ins_minu;
+                    if (funct3 == 6) match = ins_max;
+                    if (funct3 == 7) match = ins_maxu;
+                    break;
+                case 0x30:
+                    if (funct3 == 1) match = ins_rol;
+                    if (funct3 == 5) match = ins_ror;
+                    break;
+                case 0x24:
+                    if (funct3 == 1) match = ins_bclr;
+                    if (funct3 == 5) match = ins_bext;
+                    break;
+                case 0x34:
+                    if (funct3 == 1) match = ins_binv;
+                    break;
+                case 0x14:
+                    if (funct3 == 1) match = ins_bset;
+                    break;
+            }
+            break;
+        // 0b0111011 => 59
+        case 59:
+            switch(funct7)
+            {
+                case 0x04:
+                    if (funct3 == 0) match = ins_add_uw;
+                    if (funct3 == 4 && rs2 == 0) match = ins_zext_h;
+                    break;
+                case 0x10:
+                    if (funct3 == 2) match = ins_sh1add_uw;
+                    if (funct3 == 4) match = ins_sh2add_uw;
+                    if (funct3 == 6) match = ins_sh3add_uw;
+                    break;
+                case 0x30:
+                    if (funct3 == 1) match = ins_rolw;
+                    if (funct3 == 5) match = ins_rorw;
+                    break;
+            }
+            break;
+        // 0b0010011 => 19, shift amount in rs2 and funct7 bit 0 as for slli
+        case 19:
+            if (funct3 == 1 && funct6 == 0x12) match = ins_bclri;
+            if (funct3 == 1 && funct6 == 0x1a) match = ins_binvi;
+            if (funct3 == 1 && funct6 == 0x0a) match = ins_bseti;
+            if (funct3 == 5 && funct6 == 0x12) match = ins_bexti;
+            if (funct3 == 5 && funct6 == 0x18) match = ins_rori;
+            break;
+        // 0b0011011 => 27
+        case 27:
+            if (funct3 == 1 && funct6 == 0x02) match = ins_slli_uw;
+            if (funct3 == 5 && funct7 == 0x30) match = ins_roriw;
+            break;
+    }
+
+    // unary forms, selected by the whole immediate and without a second source
+    if (match == ins_default)
+    {
+        type = 'I';
+        if (opcode == 19 && funct3 == 1)
+        {
+            if (imm12 == 0x600) match = ins_clz;
+            if (imm12 == 0x601) match = ins_ctz;
+            if (imm12 == 0x602) match = ins_cpop;
+            if (imm12 == 0x604) match = ins_sext_b;
+            if (imm12 == 0x605) match = ins_sext_h;
+        }
+        if (opcode == 19 && funct3 == 5)
+        {
+            if (imm12 == 0x287) match = ins_orc_b;
+            if (imm12 == 0x6b8) match = ins_rev8;
+        }
+        if (opcode == 27 && funct3 == 1)
+        {
+            if (imm12 == 0x600) match = ins_clzw;
+            if (imm12 == 0x601) match = ins_ctzw;
+            if (imm12 == 0x602) match = ins_cpopw;
+        }
+    }
+
+    if (match == ins_default) return false;
+
+    code = match;
+    if (type == 'R')
+    {
+        decodeRType();
+    }
+    else
+    {
+        decodeIType();
+    }
+    return true;
+}
+
+#endif
+
+#if ISA_FD
+// return the code of an F or D operation with opcode 0b1010011, ins_default if illegal
+// single and double forms share a layout so the fmt field selects the double block
+Ins Decoder::decodeFloat()
+{
+    uint8_t fmt = funct7 & 0x3;
+    uint8_t rs2 = (ins >> 20) & 0x1f;
+    Ins single = ins_default;
+
+    if (fmt > 1) return ins_default;
+
+    switch(funct7 >> 2)
+    {
+        case 0x00: single = ins_fadd_s; break;
+        case 0x01: single = ins_fsub_s; break;
+        case 0x02: single = ins_fmul_s; break;
+        case 0x03: single = ins_fdiv_s; break;
+        case 0x0b:
+            if (rs2 == 0) single = ins_fsqrt_s;
+            break;
+        case 0x04:
+            if (funct3 == 0) single = ins_fsgnj_s;
+            if (funct3 == 1) single = ins_fsgnjn_s;
+            if (funct3 == 2) single = ins_fsgnjx_s;
+            break;
+        case 0x05:
+            if (funct3 == 0) single = ins_fmin_s;
+            if (funct3 == 1) single = ins_fmax_s;
+            break;
+        case 0x08:
+            // fcvt.s.d has fmt S and rs2 D, fcvt.d.s the reverse
+            if (rs2 == (fmt == 0 ? 1 : 0)) single = ins_fcvt_s_d;
+            break;
+        case 0x14:
+            if (funct3 == 0) single = ins_fle_s;
+            if (funct3 == 1) single = ins_flt_s;
+            if (funct3 == 2) single = ins_feq_s;
+            break;
+        case 0x18:
+            if (rs2 < 4) single = (Ins) (ins_fcvt_w_s + rs2);
+            break;
+        case 0x1a:
+            if (rs2 < 4) single = (Ins) (ins_fcvt_s_w + rs2);
+            break;
+        case 0x1c:
+            if (funct3 == 0 && rs2 == 0) single = ins_fmv_x_w;
+            if (funct3 == 1 && rs2 == 0) single = ins_fclass_s;
+            break;
+        case 0x1e:
+            if (funct3 == 0 && rs2 == 0) single = ins_fmv_w_x;
+            break;
+    }
+
+    if (single == ins_default || fmt == 0) return single;
+    return (Ins) (single - ins_fmadd_s + ins_fmadd_d);
+}
+
+#endif
+
+#if ISA_V
+// return the code of a vector load or store from its unit-stride and strided 8-bit forms
+// unsupported addressing modes and segments decode as illegal, leaving the code ins_default
+Ins Decoder::decodeVectorMemory(Ins unit, Ins strided)
+{
+    // width 0, 5, 6, 7 => 8, 16, 32, 64-bit elements
+    int width = funct3 == 0 ? 0 : funct3 - 4;
+    uint8_t mop = (ins >> 26) & 0x3;
+    uint8_t nf_mew = ins >> 28;
+
+    if (nf_mew != 0 || (mop == 0 && ((ins >> 20) & 0x1f) != 0) || mop == 1 || mop == 3)
+    {
+        resetIns();
+        return ins_default;
+    }
+
+    code = (Ins) ((mop == 0 ? unit : strided) + width);
+    type = 'V';
+    imm = 0;
+    decodeRType();
+    return code;
+}
+
+// return the code of a vector configuration or arithmetic instruction, ins_default if illegal
+Ins Decoder::decodeVector()
+{
+    // funct6 and operand category (funct3) select the instruction
+    struct VectorEncoding
+    {
+        uint8_t funct6;
+        uint8_t funct3;
+        Ins code;
+    };
+    static const VectorEncoding encodings[] = {
+        { 0x00, 0, ins_vadd_vv },
+        { 0x00, 4, ins_vadd_vx },
+        { 0x00, 3, ins_vadd_vi },
+        { 0x02, 0, ins_vsub_vv },
+        { 0x02, 4, ins_vsub_vx },
+        { 0x03, 4, ins_vrsub_vx },
+        { 0x03, 3, ins_vrsub_vi },
+        { 0x04, 0, ins_vminu_vv },
+        { 0x04, 4, ins_vminu_vx },
+        { 0x05, 0, ins_vmin_vv },
+        { 0x05, 4, ins_vmin_vx },
+        { 0x06, 0, ins_vmaxu_vv },
+        { 0x06, 4, ins_vmaxu_vx },
+        { 0x07, 0, ins_vmax_vv },
+        { 0x07, 4, ins_vmax_vx },
+        { 0x09, 0, ins_vand_vv },
+        { 0x09, 4, ins_vand_vx },
+        { 0x09, 3, ins_vand_vi },
+        { 0x0a, 0, ins_vor_vv },
+        { 0x0a, 4, ins_vor_vx },
+        { 0x0a, 3, ins_vor_vi },
+        { 0x0b, 0, ins_vxor_vv },
+        { 0x0b, 4, ins_vxor_vx },
+        { 0x0b, 3, ins_vxor_vi },
+        { 0x25, 0, ins_vsll_vv },
+        { 0x25, 4, ins_vsll_vx },
+        { 0x25, 3, ins_vsll_vi },
+        { 0x28, 0, ins_vsrl_vv },
+        { 0x28, 4, ins_vsrl_vx },
+        { 0x28, 3, ins_vsrl_vi },
+        { 0x29, 0, ins_vsra_vv },
+        { 0x29, 4, ins_vsra_vx },
+        { 0x29, 3, ins_vsra_vi },
+        { 0x25, 2, ins_vmul_vv },
+        { 0x25, 6, ins_vmul_vx },
+        { 0x2d, 2, ins_vmacc_vv },
+        { 0x2d, 6, ins_vmacc_vx },
+        { 0x17, 0, ins_vmv_v_v },
+        { 0x17, 4, ins_vmv_v_x },
+        { 0x17, 3, ins_vmv_v_i },
+        { 0x10, 2, ins_vmv_x_s },
+        { 0x10, 6, ins_vmv_s_x },
+        { 0x00, 2, ins_vredsum_vs },
+        { 0x01, 2, ins_vredand_vs },
+        { 0x02, 2, ins_vredor_vs },
+        { 0x03, 2, ins_vredxor_vs },
+        { 0x04, 2, ins_vredminu_vs },
+        { 0x05, 2, ins_vredmin_vs },
+        { 0x06, 2, ins_vredmaxu_vs },
+        { 0x07, 2, ins_vredmax_vs }
+    };
+
+    uint8_t funct6 = ins >> 26;
+    bool vm = (ins >> 25) & 0x1;
+    uint8_t vs2 = (ins >> 20) & 0x1f;
+
+    // configuration, 0 => vsetvli, 11 => vsetivli, 10 with funct7 0b1000000 => vsetvl
+    if (funct3 == 7)
+    {
+        if ((ins >> 31) == 0) return ins_vsetvli;
+        if (((ins >> 30) & 0x3) == 0x3) return ins_vsetivli;
+        if (funct7 == 0x40) return ins_vsetvl;
+        return ins_default;
+    }
+
+    for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++)
+    {
+        if (encodings[i].funct6 != funct6 || encodings[i].funct3 != funct3) continue;
+
+        // moves are unmasked, vmv.v.* and vmv.s.x have no vs2
+        Ins match = encodings[i].code;
+        if ((match >= ins_vmv_v_v && match <= ins_vmv_s_x) && !vm) return ins_default;
+        if ((match >= ins_vmv_v_v && match <= ins_vmv_v_i) && vs2 != 0) return ins_default;
+        if (match == ins_vmv_s_x && vs2 != 0) return ins_default;
+        return match;
+    }
+    return ins_default;
+}
+#endif
+
 // decode R-type instructions
 void Decoder::decodeRType()
 {
@@ -627,6 +1557,7 @@ void Decoder::resetIns()
     rd = 0;
     rs1 = 0;
     rs2 = 0;
+    rs3 = 0;
     funct3 = 0;
     funct7 = 0;
     imm = 0;
@@ -642,6 +1573,12 @@ uint32_t Decoder::getIns()
     return ins;
 }
 
+// return current instruction length in bytes
+uint8_t Decoder::getInsLength()
+{
+    return length;
+}
+
 // return current opcode
 uint8_t Decoder::getOpcode()
 {
@@ -666,6 +1603,12 @@ uint8_t Decoder::getRs2()
     return rs2;
 }
 
+// return current source register 3
+uint8_t Decoder::getRs3()
+{
+    return rs3;
+}
+
 // return current funct3
 uint8_t Decoder::getFunct3()
 {
@@ -696,6 +1639,12 @@ string Decoder::getInsName()
     return insNames[code];
 }
 
+// return instruction names indexed by code
+const vector<string>& Decoder::getInsNames()
+{
+    return insNames;
+}
+
 // return current instruction type (capital letter)
 char Decoder::getInsType()
 {
@@ -27,10 +27,14 @@ class Decoder {
         uint8_t rd;
         uint8_t rs1;
         uint8_t rs2;
+        uint8_t rs3;
         uint8_t funct3;
         uint8_t funct7;
         uint32_t imm;
 
+        // instruction length in bytes, 2 for compressed instructions
+        uint8_t length;
+
         // instruction properties
         Ins code;
         char type;
@@ -44,6 +48,21 @@ class Decoder {
         // decode current instruction and store parts into variables
         void decodeIns(uint32_t ins);
 
+        // expand a 16-bit compressed instruction to its 32-bit equivalent, 0 if illegal
+        static uint32_t expandCompressed(uint16_t ins);
+
+        // decode Zba, Zbb and Zbs instructions, returning false if not bit manipulation
+        bool decodeBitmanip();
+
+        // return the code of an F or D operation, ins_default if illegal
+        Ins decodeFloat();
+
+        // return the code of a vector load or store from its unit-stride and strided 8-bit forms
+        Ins decodeVectorMemory(Ins unit, Ins strided);
+
+        // return the code of a vector configuration or arithmetic instruction, ins_default if illegal
+        Ins decodeVector();
+
         // decode current instruction according to type
         void decodeRType();
         void decodeIType();
@@ -58,6 +77,9 @@ class Decoder {
         // return current instruction
         uint32_t getIns();
 
+        // return current instruction length in bytes
+        uint8_t getInsLength();
+
         // return current opcode
         uint8_t getOpcode();
 
@@ -70,6 +92,9 @@ class Decoder {
         // return current source register 1
         uint8_t getRs2();
 
+        // return current source register 3
+        uint8_t getRs3();
+
         // return current funct3
         uint8_t getFunct3();
 
@@ -85,6 +110,9 @@ class Decoder {
         // return current instruction name string
         string getInsName();
 
+        // return instruction names indexed by code
+        const vector<string>& getInsNames();
+
         // return current instruction type (capital letter)
         char getInsType();
 
@@ -0,0 +1,172 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for DRAM timing model
+**************************************************************** */
+
+#include "Dram.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+
+// Constructor
+Dram::Dram(unsigned int channels, unsigned int banks, unsigned int row_size, bool open_page,
+           unsigned int t_cas, unsigned int t_rcd, unsigned int t_rp, unsigned int t_burst)
+{
+    // configuration
+    this->channels = channels;
+    this->banks = banks;
+    this->row_size = row_size;
+    this->open_page = open_page;
+    this->t_cas = t_cas;
+    this->t_rcd = t_rcd;
+    this->t_rp = t_rp;
+    this->t_burst = t_burst;
+
+    // all banks precharged and idle
+    Bank idle = {UINT64_MAX, 0};
+    bank_state.assign(channels * banks, idle);
+    bus_ready.assign(channels, 0);
+
+    // statistics
+    reads = 0;
+    writes = 0;
+    row_hits = 0;
+    row_misses = 0;
+    row_conflicts = 0;
+    total_latency = 0;
+}
+
+// create from "channels:banks:row[:open|closed]" and "cas:rcd:rp:burst", NULL if invalid
+Dram* Dram::create(string spec, string timing)
+{
+    vector<string> fields;
+    string field;
+    stringstream ss(spec);
+    while (getline(ss, field, ':')) fields.push_back(field);
+
+    if (fields.size() < 3 || fields.size() > 4)
+    {
+        cout << "Invalid DRAM specification: " << spec << endl;
+        return NULL;
+    }
+
+    // row size in bytes with an optional k suffix
+    unsigned long channels = strtoul(fields[0].c_str(), NULL, 10);
+    unsigned long banks = strtoul(fields[1].c_str(), NULL, 10);
+    char* end;
+    unsigned long row = strtoul(fields[2].c_str(), &end, 10);
+    if (*end == 'k' || *end == 'K') row *= 1024;
+
+    bool open_page = true;
+    if (fields.size() > 3)
+    {
+        if (fields[3] == "closed") open_page = false;
+        else if (fields[3] != "open")
+        {
+            cout << "Invalid page policy: " << fields[3] << endl;
+            return NULL;
+        }
+    }
+
+    if (channels == 0 || banks == 0 || row == 0)
+    {
+        cout << "Invalid DRAM geometry: " << spec << endl;
+        return NULL;
+    }
+
+    // timing in processor cycles
+    unsigned long t[4];
+    stringstream ts(timing);
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (!getline(ts, field, ':'))
+        {
+            cout << "Invalid DRAM timing: " << timing << endl;
+            return NULL;
+        }
+        t[i] = strtoul(field.c_str(), NULL, 10);
+    }
+
+    return new Dram(channels, banks, row, open_page, t[0], t[1], t[2], t[3]);
+}
+
+// access a line at time now, returning cycles until the data is transferred
+unsigned int Dram::access(uint64_t address, bool write, uint64_t now)
+{
+    // row:bank:channel:column mapping, so consecutive rows spread over channels then banks
+    // the bank is xored with the low row bits so that rows a multiple of the bank count apart do not conflict
+    uint64_t rest = address / row_size;
+    unsigned int channel = rest % channels;
+    rest /= channels;
+    uint64_t row = rest / banks;
+    unsigned int index = channel * banks + (rest ^ row) % banks;
+    Bank& bank = bank_state[index];
+
+    if (write) writes++;
+    else reads++;
+
+    // commands wait for the bank, data waits for the channel bus
+    uint64_t start = bank.ready > now ? bank.ready : now;
+    unsigned int latency;
+    if (bank.open_row == row)
+    {
+        row_hits++;
+        latency = t_cas;
+    }
+    else if (bank.open_row == UINT64_MAX)
+    {
+        row_misses++;
+        latency = t_rcd + t_cas;
+    }
+    else
+    {
+        row_conflicts++;
+        latency = t_rp + t_rcd + t_cas;
+    }
+
+    uint64_t data = start + latency;
+    if (bus_ready[channel] > data) data = bus_ready[channel];
+    uint64_t done = data + t_burst;
+    bus_ready[channel] = done;
+
+    // closed page precharges straight after the access
+    if (open_page)
+    {
+        bank.open_row = row;
+        bank.ready = data;
+    }
+    else
+    {
+        bank.open_row = UINT64_MAX;
+        bank.ready = done + t_rp;
+    }
+
+    total_latency += done - now;
+    return done - now;
+}
+
+// print row buffer and latency statistics
+void Dram::printStats()
+{
+    uint64_t accesses = reads + writes;
+    cout << "DRAM: " << dec << channels << " channels, " << banks << " banks, ";
+    if (row_size % 1024 == 0) cout << row_size / 1024 << "KB rows, ";
+    else cout << row_size << "B rows, ";
+    cout << (open_page ? "open" : "closed") << " page, tCAS " << t_cas << ", tRCD " << t_rcd
+         << ", tRP " << t_rp << ", burst " << t_burst << endl;
+    cout << "DRAM reads: " << reads << ", writes: " << writes << ", row hits: " << row_hits
+         << ", row misses: " << row_misses << ", row conflicts: " << row_conflicts << endl;
+    if (accesses)
+    {
+        cout << "DRAM row buffer hit rate: " << fixed << setprecision(2) << 100.0 * row_hits / accesses
+             << "%, average latency: " << (double)total_latency / accesses << " cycles"
+             << defaultfloat << setprecision(6) << endl;
+    }
+}
+
+// destructor
+Dram::~Dram()
+{
+
+}
@@ -0,0 +1,66 @@
+#ifndef DRAM_H
+#define DRAM_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for DRAM timing model
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+class Dram {
+
+    private:
+
+        // per-bank state
+        struct Bank
+        {
+            uint64_t open_row;      // UINT64_MAX when precharged
+            uint64_t ready;         // cycle the bank can accept a command
+        };
+
+        // configuration
+        unsigned int channels;
+        unsigned int banks;
+        unsigned int row_size;
+        bool open_page;             // leave rows open after an access, or precharge
+        unsigned int t_cas;         // column access
+        unsigned int t_rcd;         // row activate to column access
+        unsigned int t_rp;          // precharge
+        unsigned int t_burst;       // data transfer
+
+        vector<Bank> bank_state;    // indexed by channel * banks + bank
+        vector<uint64_t> bus_ready; // per channel data bus
+
+        // statistics
+        uint64_t reads;
+        uint64_t writes;
+        uint64_t row_hits;
+        uint64_t row_misses;        // bank precharged
+        uint64_t row_conflicts;     // another row open
+        uint64_t total_latency;
+
+    public:
+
+        // Constructor
+        Dram(unsigned int channels, unsigned int banks, unsigned int row_size, bool open_page,
+             unsigned int t_cas, unsigned int t_rcd, unsigned int t_rp, unsigned int t_burst);
+
+        // create from "channels:banks:row[:open|closed]" and "cas:rcd:rp:burst", NULL if invalid
+        static Dram* create(string spec, string timing);
+
+        // access a line at time now, returning cycles until the data is transferred
+        unsigned int access(uint64_t address, bool write, uint64_t now);
+
+        // print row buffer and latency statistics
+        void printStats();
+
+        // destructor
+        ~Dram();
+};
+
+#endif
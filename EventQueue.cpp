@@ -0,0 +1,135 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for timing wheel event queue
+**************************************************************** */
+
+#include "EventQueue.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// Constructor
+EventQueue::EventQueue()
+{
+    wheel.resize(slots);
+    current = 0;
+    next = UINT64_MAX;
+    pending = 0;
+}
+
+// move overflow events into the wheel once they are within range
+void EventQueue::migrate()
+{
+    while (!overflow.empty() && overflow.begin()->first < current + slots)
+    {
+        const Event& event = overflow.begin()->second;
+        wheel[event.time & (slots - 1)].push_back(event);
+        overflow.erase(overflow.begin());
+    }
+}
+
+// find the earliest scheduled time
+void EventQueue::findNext()
+{
+    migrate();
+    for (uint64_t time = current; time < current + slots; time++)
+    {
+        if (!wheel[time & (slots - 1)].empty())
+        {
+            next = time;
+            return;
+        }
+    }
+    next = overflow.empty() ? UINT64_MAX : overflow.begin()->first;
+}
+
+// add an event, events in the past are due immediately
+void EventQueue::schedule(const Event& event)
+{
+    Event due = event;
+    if (due.time < current) due.time = current;
+    if (due.time < current + slots) wheel[due.time & (slots - 1)].push_back(due);
+    else overflow.insert(make_pair(due.time, due));
+    if (due.time < next) next = due.time;
+    pending++;
+}
+
+// remove an event due at or before now, false when none is due
+bool EventQueue::pop(uint64_t now, Event& event)
+{
+    if (next > now) return false;
+
+    // every slot before next is empty, so the wheel can advance to it
+    current = next;
+    migrate();
+    deque<Event>& slot = wheel[current & (slots - 1)];
+    event = slot.front();
+    slot.pop_front();
+    pending--;
+    if (slot.empty()) findNext();
+    return true;
+}
+
+// load "count mip set|clear bit", "count csr num value" and "count mem address value" lines
+bool EventQueue::load(string file_name)
+{
+    ifstream input_file(file_name);
+    if (!input_file.is_open())
+    {
+        cout << "Failed to open event file: " << file_name << endl;
+        return false;
+    }
+
+    string line;
+    unsigned int line_count = 0;
+    while (getline(input_file, line))
+    {
+        line_count++;
+        line = line.substr(0, line.find('#'));
+        stringstream ss(line);
+        uint64_t time;
+        string action;
+        if (!(ss >> time)) continue;
+
+        Event event = {time, event_mip_set, 0, 0};
+        bool valid = false;
+        if (ss >> action)
+        {
+            if (action == "mip")
+            {
+                string op;
+                valid = (ss >> op >> hex >> event.arg0) && (op == "set" || op == "clear") && event.arg0 < 64;
+                event.type = op == "set" ? event_mip_set : event_mip_clear;
+            }
+            else if (action == "csr")
+            {
+                valid = (ss >> hex >> event.arg0 >> event.arg1) && event.arg0 <= 0xfff;
+                event.type = event_csr;
+            }
+            else if (action == "mem")
+            {
+                valid = (bool)(ss >> hex >> event.arg0 >> event.arg1);
+                event.type = event_mem;
+            }
+        }
+        if (!valid)
+        {
+            cout << "Invalid event on line " << dec << line_count << " of " << file_name << endl;
+            return false;
+        }
+        schedule(event);
+    }
+    return true;
+}
+
+// return number of scheduled events
+uint64_t EventQueue::size()
+{
+    return pending;
+}
+
+// destructor
+EventQueue::~EventQueue()
+{
+
+}
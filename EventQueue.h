@@ -0,0 +1,85 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for timing wheel event queue
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+
+using namespace std;
+
+class EventQueue {
+
+    public:
+
+        // event kinds handled by the processor
+        enum Type
+        {
+            event_clint,        // CLINT timer expiry, arg0 is the schedule generation
+            event_mip_set,      // set mip bit arg0
+            event_mip_clear,    // clear mip bit arg0
+            event_csr,          // write csr arg0 with arg1
+            event_mem           // write doubleword at arg0 with arg1
+        };
+
+        struct Event
+        {
+            uint64_t time;
+            Type type;
+            uint64_t arg0;
+            uint64_t arg1;
+        };
+
+    private:
+
+        // wheel slots hold events due within slots of current, later events wait in overflow
+        static const unsigned int wheel_bits = 10;
+        static const uint64_t slots = 1u << wheel_bits;
+
+        vector<deque<Event> > wheel;
+        multimap<uint64_t, Event> overflow;
+        uint64_t current;           // no events are due before this time
+        uint64_t next;              // earliest scheduled time, UINT64_MAX when empty
+        uint64_t pending;
+
+        // move overflow events into the wheel once they are within range
+        void migrate();
+
+        // find the earliest scheduled time
+        void findNext();
+
+    public:
+
+        // Constructor
+        EventQueue();
+
+        // add an event, events in the past are due immediately
+        void schedule(const Event& event);
+
+        // return the time of the earliest event, UINT64_MAX when empty
+        uint64_t nextDeadline()
+        {
+            return next;
+        }
+
+        // remove an event due at or before now, false when none is due
+        bool pop(uint64_t now, Event& event);
+
+        // load "count mip set|clear bit", "count csr num value" and "count mem address value" lines
+        // count is decimal, other numbers are hex
+        bool load(string file_name);
+
+        // return number of scheduled events
+        uint64_t size();
+
+        // destructor
+        ~EventQueue();
+};
+
+#endif
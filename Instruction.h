@@ -69,7 +69,216 @@ namespace RV64I
         ins_csrrc,
         ins_csrrwi,
         ins_csrrsi,
-        ins_csrrci
+        ins_csrrci,
+        ins_wfi,
+        ins_sret,
+        ins_sfence_vma,
+        ins_mul,
+        ins_mulh,
+        ins_mulhsu,
+        ins_mulhu,
+        ins_div,
+        ins_divu,
+        ins_rem,
+        ins_remu,
+        ins_mulw,
+        ins_divw,
+        ins_divuw,
+        ins_remw,
+        ins_remuw,
+        ins_lr_w,
+        ins_sc_w,
+        ins_amoswap_w,
+        ins_amoadd_w,
+        ins_amoxor_w,
+        ins_amoand_w,
+        ins_amoor_w,
+        ins_amomin_w,
+        ins_amomax_w,
+        ins_amominu_w,
+        ins_amomaxu_w,
+        ins_lr_d,
+        ins_sc_d,
+        ins_amoswap_d,
+        ins_amoadd_d,
+        ins_amoxor_d,
+        ins_amoand_d,
+        ins_amoor_d,
+        ins_amomin_d,
+        ins_amomax_d,
+        ins_amominu_d,
+        ins_amomaxu_d,
+        ins_sh1add,
+        ins_sh2add,
+        ins_sh3add,
+        ins_add_uw,
+        ins_sh1add_uw,
+        ins_sh2add_uw,
+        ins_sh3add_uw,
+        ins_slli_uw,
+        ins_andn,
+        ins_orn,
+        ins_xnor,
+        ins_clz,
+        ins_ctz,
+        ins_cpop,
+        ins_clzw,
+        ins_ctzw,
+        ins_cpopw,
+        ins_min,
+        ins_minu,
+        ins_max,
+        ins_maxu,
+        ins_sext_b,
+        ins_sext_h,
+        ins_zext_h,
+        ins_rol,
+        ins_ror,
+        ins_rori,
+        ins_rolw,
+        ins_rorw,
+        ins_roriw,
+        ins_orc_b,
+        ins_rev8,
+        ins_bclr,
+        ins_bclri,
+        ins_bext,
+        ins_bexti,
+        ins_binv,
+        ins_binvi,
+        ins_bset,
+        ins_bseti,
+        ins_flw,
+        ins_fsw,
+        ins_fld,
+        ins_fsd,
+        ins_fmadd_s,
+        ins_fmsub_s,
+        ins_fnmsub_s,
+        ins_fnmadd_s,
+        ins_fadd_s,
+        ins_fsub_s,
+        ins_fmul_s,
+        ins_fdiv_s,
+        ins_fsqrt_s,
+        ins_fcvt_w_s,
+        ins_fcvt_wu_s,
+        ins_fcvt_l_s,
+        ins_fcvt_lu_s,
+        ins_fcvt_s_w,
+        ins_fcvt_s_wu,
+        ins_fcvt_s_l,
+        ins_fcvt_s_lu,
+        ins_fcvt_s_d,
+        ins_fsgnj_s,
+        ins_fsgnjn_s,
+        ins_fsgnjx_s,
+        ins_fmin_s,
+        ins_fmax_s,
+        ins_feq_s,
+        ins_flt_s,
+        ins_fle_s,
+        ins_fclass_s,
+        ins_fmv_x_w,
+        ins_fmv_w_x,
+        ins_fmadd_d,
+        ins_fmsub_d,
+        ins_fnmsub_d,
+        ins_fnmadd_d,
+        ins_fadd_d,
+        ins_fsub_d,
+        ins_fmul_d,
+        ins_fdiv_d,
+        ins_fsqrt_d,
+        ins_fcvt_w_d,
+        ins_fcvt_wu_d,
+        ins_fcvt_l_d,
+        ins_fcvt_lu_d,
+        ins_fcvt_d_w,
+        ins_fcvt_d_wu,
+        ins_fcvt_d_l,
+        ins_fcvt_d_lu,
+        ins_fcvt_d_s,
+        ins_fsgnj_d,
+        ins_fsgnjn_d,
+        ins_fsgnjx_d,
+        ins_fmin_d,
+        ins_fmax_d,
+        ins_feq_d,
+        ins_flt_d,
+        ins_fle_d,
+        ins_fclass_d,
+        ins_fmv_x_d,
+        ins_fmv_d_x,
+        ins_vsetvli,
+        ins_vsetivli,
+        ins_vsetvl,
+        ins_vle8_v,
+        ins_vle16_v,
+        ins_vle32_v,
+        ins_vle64_v,
+        ins_vlse8_v,
+        ins_vlse16_v,
+        ins_vlse32_v,
+        ins_vlse64_v,
+        ins_vse8_v,
+        ins_vse16_v,
+        ins_vse32_v,
+        ins_vse64_v,
+        ins_vsse8_v,
+        ins_vsse16_v,
+        ins_vsse32_v,
+        ins_vsse64_v,
+        ins_vadd_vv,
+        ins_vadd_vx,
+        ins_vadd_vi,
+        ins_vsub_vv,
+        ins_vsub_vx,
+        ins_vrsub_vx,
+        ins_vrsub_vi,
+        ins_vminu_vv,
+        ins_vminu_vx,
+        ins_vmin_vv,
+        ins_vmin_vx,
+        ins_vmaxu_vv,
+        ins_vmaxu_vx,
+        ins_vmax_vv,
+        ins_vmax_vx,
+        ins_vand_vv,
+        ins_vand_vx,
+        ins_vand_vi,
+        ins_vor_vv,
+        ins_vor_vx,
+        ins_vor_vi,
+        ins_vxor_vv,
+        ins_vxor_vx,
+        ins_vxor_vi,
+        ins_vsll_vv,
+        ins_vsll_vx,
+        ins_vsll_vi,
+        ins_vsrl_vv,
+        ins_vsrl_vx,
+        ins_vsrl_vi,
+        ins_vsra_vv,
+        ins_vsra_vx,
+        ins_vsra_vi,
+        ins_vmul_vv,
+        ins_vmul_vx,
+        ins_vmacc_vv,
+        ins_vmacc_vx,
+        ins_vmv_v_v,
+        ins_vmv_v_x,
+        ins_vmv_v_i,
+        ins_vmv_x_s,
+        ins_vmv_s_x,
+        ins_vredsum_vs,
+        ins_vredand_vs,
+        ins_vredor_vs,
+        ins_vredxor_vs,
+        ins_vredminu_vs,
+        ins_vredmin_vs,
+        ins_vredmaxu_vs,
+        ins_vredmax_vs
     };
 }
 
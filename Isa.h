@@ -0,0 +1,56 @@
+#ifndef ISA_H
+#define ISA_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Compile-time selection of the instruction set extensions
+**************************************************************** */
+
+#include <cstdint>
+
+// every extension is built unless its macro is defined as 0, for example with
+// make ISA=rv64i or make ISAFLAGS="-DISA_V=0"; disabled extensions are left out
+// of the decoder and executeIns by the preprocessor, so their encodings are illegal
+#ifndef ISA_M
+#define ISA_M 1         // multiply and divide
+#endif
+#ifndef ISA_A
+#define ISA_A 1         // lr, sc and amos
+#endif
+#ifndef ISA_C
+#define ISA_C 1         // 16-bit compressed instructions
+#endif
+#ifndef ISA_FD
+#define ISA_FD 1        // single and double precision floating point
+#endif
+#ifndef ISA_B
+#define ISA_B 1         // Zba, Zbb and Zbs bit manipulation
+#endif
+#ifndef ISA_V
+#define ISA_V 1         // vector subset
+#endif
+#ifndef ISA_ZICSR
+#define ISA_ZICSR 1     // csr instructions
+#endif
+
+// the selected extensions as constants, for code that only needs to know rather than be left out
+struct Isa
+{
+    static constexpr bool m = ISA_M;
+    static constexpr bool a = ISA_A;
+    static constexpr bool c = ISA_C;
+    static constexpr bool fd = ISA_FD;
+    static constexpr bool b = ISA_B;
+    static constexpr bool v = ISA_V;
+    static constexpr bool zicsr = ISA_ZICSR;
+
+    // RV64 with I, S and U always present, one bit per letter from A in bit 0
+    static constexpr uint64_t misa = 0x8000000000000000ULL | (1ULL << 8) | (1ULL << 18) | (1ULL << 20)
+        | (m ? 1ULL << 12 : 0) | (a ? 1ULL << 0 : 0) | (c ? 1ULL << 2 : 0) | (fd ? 1ULL << 5 | 1ULL << 3 : 0)
+        | (b ? 1ULL << 1 : 0) | (v ? 1ULL << 21 : 0);
+
+    // mstatus.fs and mstatus.vs are read-only zero without floating point or vectors
+    static constexpr uint64_t mstatus_mask = 0x7e7faaULL & ~(fd ? 0 : 0x6000ULL) & ~(v ? 0 : 0x600ULL);
+};
+
+#endif
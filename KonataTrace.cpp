@@ -0,0 +1,146 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for pipeline trace output in Kanata format (Konata viewer)
+**************************************************************** */
+
+#include "KonataTrace.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+// buffered output handed to the writer thread in chunks of this size
+static const size_t buffer_size = 1 << 16;
+
+// Constructor, opens the file and starts the writer thread
+KonataTrace::KonataTrace(string file_name, const vector<string>& names, uint64_t start, uint64_t count)
+{
+    this->names = names;
+    this->start = start;
+    this->end = start + count;
+    sequence = 0;
+    order = 0;
+    next_id = 0;
+    last_cycle = 0;
+    first_cycle = true;
+    closing = false;
+
+    output.open(file_name);
+    if (!output.is_open())
+    {
+        cout << "Failed to open trace file: " << file_name << endl;
+        return;
+    }
+    buffer.reserve(buffer_size);
+    buffer += "Kanata\t0004\n";
+    writer = thread(&KonataTrace::writeLoop, this);
+}
+
+// return true if the file was opened
+bool KonataTrace::isOpen()
+{
+    return output.is_open();
+}
+
+// queue an event
+void KonataTrace::add(uint64_t cycle, const string& text)
+{
+    Event event = {cycle, order++, text};
+    pending.push(event);
+}
+
+// format events due before cycle into the buffer
+void KonataTrace::release(uint64_t cycle)
+{
+    while (!pending.empty() && pending.top().cycle < cycle)
+    {
+        const Event& event = pending.top();
+        if (first_cycle)
+        {
+            buffer += "C=\t" + to_string(event.cycle) + "\n";
+            first_cycle = false;
+        }
+        else if (event.cycle != last_cycle)
+        {
+            buffer += "C\t" + to_string(event.cycle - last_cycle) + "\n";
+        }
+        last_cycle = event.cycle;
+        buffer += event.text;
+        pending.pop();
+    }
+
+    if (buffer.size() >= buffer_size)
+    {
+        unique_lock<mutex> guard(lock);
+        full_buffers.push_back(string());
+        full_buffers.back().swap(buffer);
+        buffer.reserve(buffer_size);
+        ready.notify_one();
+    }
+}
+
+// record stage start cycles for the last sampled instruction
+void KonataTrace::record(const RetiredIns& rec, unsigned int stages, const char* const stage_names[], const uint64_t cycles[])
+{
+    if (!output.is_open()) return;
+
+    // instructions are fetched in order, so nothing later can happen before this fetch
+    release(cycles[0]);
+
+    string id = to_string(next_id);
+    stringstream label;
+    label << setw(16) << setfill('0') << hex << rec.pc << ": "
+          << (rec.code < names.size() ? names[rec.code] : "?")
+          << " (" << setw(8) << setfill('0') << hex << rec.ins << ")";
+
+    add(cycles[0], "I\t" + id + "\t" + to_string(sequence - 1) + "\t0\n");
+    add(cycles[0], "L\t" + id + "\t0\t" + label.str() + "\n");
+    for (unsigned int i = 0; i < stages; i++)
+    {
+        add(cycles[i], "S\t" + id + "\t0\t" + stage_names[i] + "\n");
+        add(cycles[i + 1], "E\t" + id + "\t0\t" + stage_names[i] + "\n");
+    }
+    add(cycles[stages], "R\t" + id + "\t" + id + "\t0\n");
+    next_id++;
+}
+
+// write buffers until closed
+void KonataTrace::writeLoop()
+{
+    unique_lock<mutex> guard(lock);
+    while (true)
+    {
+        ready.wait(guard, [this] { return closing || !full_buffers.empty(); });
+        while (!full_buffers.empty())
+        {
+            string data;
+            data.swap(full_buffers.front());
+            full_buffers.pop_front();
+            guard.unlock();
+            output.write(data.data(), data.size());
+            guard.lock();
+        }
+        if (closing) break;
+    }
+}
+
+// write remaining events and stop the writer thread
+void KonataTrace::close()
+{
+    if (!writer.joinable()) return;
+    release(UINT64_MAX);
+    {
+        unique_lock<mutex> guard(lock);
+        full_buffers.push_back(string());
+        full_buffers.back().swap(buffer);
+        closing = true;
+        ready.notify_one();
+    }
+    writer.join();
+    output.close();
+}
+
+// destructor
+KonataTrace::~KonataTrace()
+{
+    close();
+}
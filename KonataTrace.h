@@ -0,0 +1,98 @@
+#ifndef KONATATRACE_H
+#define KONATATRACE_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for pipeline trace output in Kanata format (Konata viewer)
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <queue>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+
+#include "Retired.h"
+
+using namespace std;
+
+class KonataTrace {
+
+    private:
+
+        // a line of output due at a cycle, ordered by cycle then creation
+        struct Event
+        {
+            uint64_t cycle;
+            uint64_t order;
+            string text;
+            bool operator>(const Event& other) const
+            {
+                return cycle != other.cycle ? cycle > other.cycle : order > other.order;
+            }
+        };
+
+        // instruction names indexed by code
+        vector<string> names;
+
+        // window of retired instructions to trace
+        uint64_t start;
+        uint64_t end;
+        uint64_t sequence;
+
+        // events not yet written, released once no later instruction can precede them
+        priority_queue<Event, vector<Event>, greater<Event> > pending;
+        uint64_t order;
+        uint64_t next_id;
+        uint64_t last_cycle;
+        bool first_cycle;
+
+        // output buffer handed to the writer thread when full
+        string buffer;
+        ofstream output;
+        thread writer;
+        mutex lock;
+        condition_variable ready;
+        deque<string> full_buffers;
+        bool closing;
+
+        // queue an event
+        void add(uint64_t cycle, const string& text);
+
+        // format events due before cycle into the buffer
+        void release(uint64_t cycle);
+
+        // write buffers until closed
+        void writeLoop();
+
+    public:
+
+        // Constructor, opens the file and starts the writer thread
+        KonataTrace(string file_name, const vector<string>& names, uint64_t start, uint64_t count);
+
+        // return true if the file was opened
+        bool isOpen();
+
+        // count a retired instruction, true when it falls inside the window
+        bool sample()
+        {
+            sequence++;
+            return sequence > start && sequence <= end;
+        }
+
+        // record stage start cycles for the last sampled instruction
+        // cycles has stages + 1 entries, the last being the retire cycle
+        void record(const RetiredIns& rec, unsigned int stages, const char* const stage_names[], const uint64_t cycles[]);
+
+        // write remaining events and stop the writer thread
+        void close();
+
+        // destructor
+        ~KonataTrace();
+};
+
+#endif
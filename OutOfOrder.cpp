@@ -0,0 +1,265 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for out-of-order superscalar timing model
+**************************************************************** */
+
+#include "OutOfOrder.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Constructor
+OutOfOrder::OutOfOrder(unsigned int width, unsigned int rob_size, unsigned int iq_size, unsigned int phys_regs,
+                       unsigned int alu_units, unsigned int lsu_units)
+{
+    // core parameters, at least one of everything
+    this->width = max(width, 1u);
+    this->rob_size = max(rob_size, 1u);
+    this->iq_size = max(iq_size, 1u);
+    this->phys_regs = max(phys_regs, 33u);
+    units[fu_alu] = max(alu_units, 1u);
+    units[fu_lsu] = max(lsu_units, 1u);
+
+    // latencies
+    frontend_depth = 3;     // fetch, decode, rename
+    load_latency = 2;       // address generation and cache access
+    trap_latency = 3;
+
+    // pipeline state
+    fetch_cycle = 0;
+    fetch_count = 0;
+    fetch_break = false;
+    dispatch_cycle = 0;
+    dispatch_count = 0;
+    rob_commit.assign(this->rob_size, 0);
+    rob_head = 0;
+    rob_tail = 0;
+    for (int fu = 0; fu < fu_count; fu++)
+    {
+        calendar_cycle[fu].assign(calendar_size, UINT64_MAX);
+        calendar_used[fu].assign(calendar_size, 0);
+    }
+    for (unsigned int i = 0; i < reg_slots; i++)
+    {
+        reg_ready[i] = 0;
+    }
+    commit_cycle = 0;
+    commit_count = 0;
+
+    // statistics
+    instructions = 0;
+    rob_histogram.assign(this->rob_size + 1, 0);
+    iq_histogram.assign(this->iq_size + 1, 0);
+    rob_full_stalls = 0;
+    iq_full_stalls = 0;
+    reg_full_stalls = 0;
+    mispredicts = 0;
+}
+
+// reserve a functional unit at or after cycle, returning the issue cycle
+uint64_t OutOfOrder::reserveUnit(FuClass fu, uint64_t cycle)
+{
+    while (true)
+    {
+        unsigned int slot = cycle % calendar_size;
+        if (calendar_cycle[fu][slot] != cycle)
+        {
+            // slot last used by a different cycle
+            calendar_cycle[fu][slot] = cycle;
+            calendar_used[fu][slot] = 0;
+        }
+        if (calendar_used[fu][slot] < units[fu])
+        {
+            calendar_used[fu][slot]++;
+            return cycle;
+        }
+        cycle++;
+    }
+}
+
+// advance the model by one retired instruction
+void OutOfOrder::retire(const RetiredIns& rec)
+{
+    Ins code = rec.code;
+    unsigned int sources[4];
+    unsigned int num_sources = sourceRegs(rec, sources);
+    unsigned int dest;
+    bool writes_rd = destReg(rec, dest);
+    bool renames_x = writes_rd && dest < 32;
+    uint64_t stall;
+
+    // fetch up to width instructions per cycle, a taken control transfer ends the group
+    if (fetch_count == width || fetch_break)
+    {
+        fetch_cycle++;
+        fetch_count = 0;
+        fetch_break = false;
+    }
+    fetch_count++;
+
+    // an instruction cache miss stalls the front end
+    if (rec.fetch_penalty != 0)
+    {
+        fetch_cycle += rec.fetch_penalty;
+        fetch_count = 1;
+    }
+    uint64_t fetch = fetch_cycle;
+
+    // dispatch in order behind the front end, up to width per cycle
+    uint64_t dispatch = max(fetch_cycle + frontend_depth, dispatch_cycle);
+    if (dispatch == dispatch_cycle && dispatch_count == width) dispatch++;
+
+    // csr and system instructions wait for the rob to drain
+    if (isCsr(code) || isSystem(code)) dispatch = max(dispatch, commit_cycle + 1);
+
+    // free rob entries committed before dispatch, then wait for a free entry
+    while (rob_head < rob_tail && rob_commit[rob_head % rob_size] < dispatch) rob_head++;
+    if (rob_tail - rob_head == rob_size)
+    {
+        stall = rob_commit[rob_head % rob_size] + 1 - dispatch;
+        rob_full_stalls += stall;
+        dispatch += stall;
+        rob_head++;
+    }
+
+    // free issue queue entries issued before dispatch, then wait for a free entry
+    while (!iq_release.empty() && iq_release.top() < dispatch) iq_release.pop();
+    while (iq_release.size() >= iq_size)
+    {
+        stall = max(iq_release.top() + 1, dispatch) - dispatch;
+        iq_full_stalls += stall;
+        dispatch += stall;
+        iq_release.pop();
+    }
+
+    // free integer physical registers released before dispatch, then wait for a free register
+    if (renames_x)
+    {
+        while (!reg_release.empty() && reg_release.top() < dispatch) reg_release.pop();
+        while (reg_release.size() >= phys_regs - 32)
+        {
+            stall = max(reg_release.top() + 1, dispatch) - dispatch;
+            reg_full_stalls += stall;
+            dispatch += stall;
+            reg_release.pop();
+        }
+    }
+
+    if (dispatch != dispatch_cycle)
+    {
+        dispatch_cycle = dispatch;
+        dispatch_count = 0;
+    }
+    dispatch_count++;
+
+    // occupancy seen by this instruction at dispatch
+    rob_histogram[rob_tail - rob_head]++;
+    iq_histogram[iq_release.size()]++;
+
+    // a full back end holds the front end
+    if (dispatch > fetch_cycle + frontend_depth)
+    {
+        fetch_cycle = dispatch - frontend_depth;
+        fetch_count = 1;
+    }
+
+    // issue when operands are ready and a unit is free
+    uint64_t ready = dispatch + 1;
+    for (unsigned int i = 0; i < num_sources; i++) ready = max(ready, reg_ready[sources[i]]);
+    bool is_mem = isLoad(code) || isStore(code);
+    uint64_t issue = reserveUnit(is_mem ? fu_lsu : fu_alu, ready);
+    iq_release.push(issue);
+
+    // complete and wake up dependants
+    uint64_t complete = issue + (isLoad(code) ? load_latency + rec.mem_penalty : 1);
+    if (writes_rd) reg_ready[dest] = complete;
+
+    // commit in order, up to width per cycle
+    uint64_t commit = max(complete + 1, commit_cycle);
+    if (commit == commit_cycle && commit_count == width) commit++;
+    if (commit != commit_cycle)
+    {
+        commit_cycle = commit;
+        commit_count = 0;
+    }
+    commit_count++;
+    rob_commit[rob_tail % rob_size] = commit;
+    rob_tail++;
+
+    // the previous mapping of rd is freed when this instruction commits
+    if (renames_x) reg_release.push(commit);
+
+    // redirect the front end
+    if (rec.trap)
+    {
+        // refetch from the trap vector after the trap commits
+        fetch_cycle = max(fetch_cycle, commit + trap_latency);
+        fetch_count = 0;
+    }
+    else if (rec.predicted ? rec.mispredict : rec.next_pc != rec.pc + rec.len)
+    {
+        // refetch the correct path once the transfer resolves, without a predictor fetch
+        // continues sequentially so every taken transfer redirects, as in the pipeline model
+        fetch_cycle = max(fetch_cycle, complete + 1);
+        fetch_count = 0;
+        fetch_break = false;
+        mispredicts++;
+    }
+    else if (code == ins_jal || code == ins_jalr || code == ins_mret || code == ins_sret || rec.next_pc != rec.pc + rec.len)
+    {
+        fetch_break = true;
+    }
+
+    // fetch, dispatch, issue, then complete until commit
+    if (trace != NULL && trace->sample())
+    {
+        static const char* const stages[] = {"F", "Ds", "Is", "Cm"};
+        uint64_t cycles[] = {fetch, dispatch, issue, complete, commit};
+        trace->record(rec, 4, stages, cycles);
+    }
+
+    instructions++;
+}
+
+// return cycles until the last retired instruction commits
+uint64_t OutOfOrder::getCycles()
+{
+    if (instructions == 0) return 0;
+    return commit_cycle + 1;
+}
+
+// print a histogram in eight buckets
+void OutOfOrder::printHistogram(const char* name, const vector<uint64_t>& histogram)
+{
+    size_t bucket = (histogram.size() + 7) / 8;
+
+    cout << name << " occupancy:" << endl;
+    for (size_t low = 0; low < histogram.size(); low += bucket)
+    {
+        size_t high = min(low + bucket, histogram.size()) - 1;
+        uint64_t count = 0;
+        for (size_t i = low; i <= high; i++) count += histogram[i];
+        cout << "  " << dec << setfill(' ') << setw(4) << low << "-" << setw(4) << high << ": " << count;
+        if (instructions) cout << " (" << fixed << setprecision(1) << 100.0 * count / instructions << "%)";
+        cout << defaultfloat << setprecision(6) << endl;
+    }
+}
+
+// print IPC and occupancy histograms
+void OutOfOrder::printStats()
+{
+    cout << "OoO instructions: " << dec << instructions << endl;
+    cout << "OoO IPC: " << (getCycles() ? (double) instructions / getCycles() : 0) << endl;
+    cout << "Dispatch stall cycles (ROB full): " << dec << rob_full_stalls << endl;
+    cout << "Dispatch stall cycles (IQ full): " << dec << iq_full_stalls << endl;
+    cout << "Dispatch stall cycles (registers): " << dec << reg_full_stalls << endl;
+    cout << "Front end redirects (mispredictions): " << dec << mispredicts << endl;
+    printHistogram("ROB", rob_histogram);
+    printHistogram("IQ", iq_histogram);
+}
+
+// destructor
+OutOfOrder::~OutOfOrder()
+{
+
+}
@@ -0,0 +1,105 @@
+#ifndef OUTOFORDER_H
+#define OUTOFORDER_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for out-of-order superscalar timing model
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <functional>
+#include "TimingModel.h"
+
+using namespace std;
+
+class OutOfOrder : public TimingModel {
+
+    private:
+
+        // functional unit classes
+        enum FuClass
+        {
+            fu_alu,
+            fu_lsu,
+            fu_count
+        };
+
+        // core parameters
+        unsigned int width;         // fetch, dispatch and commit width
+        unsigned int rob_size;
+        unsigned int iq_size;
+        unsigned int phys_regs;
+        unsigned int units[fu_count];
+
+        // latencies in cycles
+        unsigned int frontend_depth;
+        unsigned int load_latency;
+        unsigned int trap_latency;
+
+        // front end
+        uint64_t fetch_cycle;       // cycle of the current fetch group
+        unsigned int fetch_count;   // instructions in the current fetch group
+        bool fetch_break;           // taken control transfer ends the fetch group
+
+        // dispatch
+        uint64_t dispatch_cycle;
+        unsigned int dispatch_count;
+
+        // reorder buffer as a ring of commit cycles, oldest at rob_head
+        vector<uint64_t> rob_commit;
+        uint64_t rob_head;          // sequence number of the oldest uncommitted instruction
+        uint64_t rob_tail;          // sequence number of the next instruction
+
+        // issue queue and physical registers as heaps of release cycles
+        priority_queue<uint64_t,vector<uint64_t>,greater<uint64_t>> iq_release;
+        priority_queue<uint64_t,vector<uint64_t>,greater<uint64_t>> reg_release;
+
+        // functional unit reservation calendar, indexed by cycle
+        static const unsigned int calendar_size = 8192;
+        vector<uint64_t> calendar_cycle[fu_count];
+        vector<unsigned int> calendar_used[fu_count];
+
+        // register scoreboard
+        uint64_t reg_ready[reg_slots];
+
+        // commit
+        uint64_t commit_cycle;
+        unsigned int commit_count;
+
+        // statistics
+        uint64_t instructions;
+        vector<uint64_t> rob_histogram;
+        vector<uint64_t> iq_histogram;
+        uint64_t rob_full_stalls;
+        uint64_t iq_full_stalls;
+        uint64_t reg_full_stalls;
+        uint64_t mispredicts;
+
+        // reserve a functional unit at or after cycle, returning the issue cycle
+        uint64_t reserveUnit(FuClass fu, uint64_t cycle);
+
+        // print a histogram in eight buckets
+        void printHistogram(const char* name, const vector<uint64_t>& histogram);
+
+    public:
+
+        // Constructor
+        OutOfOrder(unsigned int width, unsigned int rob_size, unsigned int iq_size, unsigned int phys_regs,
+                   unsigned int alu_units, unsigned int lsu_units);
+
+        // advance the model by one retired instruction
+        void retire(const RetiredIns& rec) override;
+
+        // return cycles until the last retired instruction commits
+        uint64_t getCycles() override;
+
+        // print IPC and occupancy histograms
+        void printStats() override;
+
+        // destructor
+        ~OutOfOrder();
+};
+
+#endif
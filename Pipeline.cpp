@@ -0,0 +1,155 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for in-order 5-stage pipeline timing model
+**************************************************************** */
+
+#include "Pipeline.h"
+#include <iostream>
+#include <algorithm>
+
+// Constructor
+Pipeline::Pipeline(unsigned int load_use_latency, unsigned int branch_penalty, unsigned int jump_penalty,
+                   unsigned int trap_latency, unsigned int csr_latency)
+{
+    // latencies
+    this->load_use_latency = load_use_latency;
+    this->branch_penalty = branch_penalty;
+    this->jump_penalty = jump_penalty;
+    this->trap_latency = trap_latency;
+    this->csr_latency = csr_latency;
+
+    // pipeline state
+    next_fetch = 0;
+    last_ex = 0;
+    last_wb = 0;
+    for (unsigned int i = 0; i < reg_slots; i++)
+    {
+        reg_ready[i] = 0;
+    }
+
+    // statistics
+    instructions = 0;
+    load_use_stalls = 0;
+    branch_stalls = 0;
+    jump_stalls = 0;
+    trap_stalls = 0;
+    csr_stalls = 0;
+    fetch_stalls = 0;
+    mem_stalls = 0;
+}
+
+// advance the pipeline by one retired instruction
+void Pipeline::retire(const RetiredIns& rec)
+{
+    Ins code = rec.code;
+
+    // classify instruction
+    bool is_load = isLoad(code);
+    bool is_csr = isCsr(code);
+    bool is_branch = isBranch(code);
+    unsigned int sources[4];
+    unsigned int num_sources = sourceRegs(rec, sources);
+    unsigned int dest;
+    bool writes_rd = destReg(rec, dest);
+
+    // IF and ID follow the previous instruction, ID waits for an instruction cache miss
+    uint64_t if_cycle = next_fetch;
+    uint64_t id_cycle = if_cycle + 1 + rec.fetch_penalty;
+    fetch_stalls += rec.fetch_penalty;
+
+    // EX waits for the previous instruction to leave EX and for bypassed operands
+    uint64_t ex_cycle = max(id_cycle + 1, last_ex + 1);
+    uint64_t ready = ex_cycle;
+    for (unsigned int i = 0; i < num_sources; i++) ready = max(ready, reg_ready[sources[i]]);
+    load_use_stalls += ready - ex_cycle;
+    ex_cycle = ready;
+
+    // CSR accesses hold EX
+    uint64_t ex_done = ex_cycle;
+    if (is_csr)
+    {
+        ex_done += csr_latency;
+        csr_stalls += csr_latency;
+    }
+
+    // MEM and WB, a data cache miss blocks MEM
+    uint64_t mem_cycle = ex_done + 1;
+    uint64_t wb_cycle = mem_cycle + 1 + rec.mem_penalty;
+    mem_stalls += rec.mem_penalty;
+
+    // result available for bypass after EX, or after MEM for loads
+    if (writes_rd)
+    {
+        reg_ready[dest] = is_load ? ex_cycle + 1 + load_use_latency + rec.mem_penalty : ex_done + 1;
+    }
+
+    // later instructions cannot leave EX while MEM is blocked
+    last_ex = ex_done + rec.mem_penalty;
+    last_wb = wb_cycle;
+
+    // IF stalls behind a stalled ID or EX
+    next_fetch = max(id_cycle, last_ex - 1);
+
+    // redirect penalties
+    if (rec.trap)
+    {
+        next_fetch += trap_latency;
+        trap_stalls += trap_latency;
+    }
+    else if (code == ins_mret || code == ins_sret)
+    {
+        next_fetch += branch_penalty;
+        branch_stalls += branch_penalty;
+    }
+    else if (code == ins_jal || code == ins_jalr || is_branch)
+    {
+        // without a predictor fetch continues sequentially, so every taken transfer redirects
+        bool redirect = rec.predicted ? rec.mispredict : rec.next_pc != rec.pc + rec.len;
+        if (redirect && code == ins_jal)
+        {
+            next_fetch += jump_penalty;
+            jump_stalls += jump_penalty;
+        }
+        else if (redirect)
+        {
+            next_fetch += branch_penalty;
+            branch_stalls += branch_penalty;
+        }
+    }
+
+    if (trace != NULL && trace->sample())
+    {
+        static const char* const stages[] = {"IF", "ID", "EX", "MEM", "WB"};
+        uint64_t cycles[] = {if_cycle, id_cycle, ex_cycle, mem_cycle, wb_cycle, wb_cycle + 1};
+        trace->record(rec, 5, stages, cycles);
+    }
+
+    instructions++;
+}
+
+// return cycles until the last retired instruction leaves WB
+uint64_t Pipeline::getCycles()
+{
+    if (instructions == 0) return 0;
+    return last_wb + 1;
+}
+
+// print stall breakdown
+void Pipeline::printStats()
+{
+    cout << "Pipeline instructions: " << dec << instructions << endl;
+    cout << "Pipeline CPI: " << (instructions ? (double) getCycles() / instructions : 0) << endl;
+    cout << "Stall cycles (load-use): " << dec << load_use_stalls << endl;
+    cout << "Stall cycles (branch): " << dec << branch_stalls << endl;
+    cout << "Stall cycles (jump): " << dec << jump_stalls << endl;
+    cout << "Stall cycles (trap): " << dec << trap_stalls << endl;
+    cout << "Stall cycles (csr): " << dec << csr_stalls << endl;
+    cout << "Stall cycles (instruction cache): " << dec << fetch_stalls << endl;
+    cout << "Stall cycles (data cache): " << dec << mem_stalls << endl;
+}
+
+// destructor
+Pipeline::~Pipeline()
+{
+
+}
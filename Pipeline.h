@@ -0,0 +1,60 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for in-order 5-stage pipeline timing model
+**************************************************************** */
+
+#include <cstdint>
+#include "TimingModel.h"
+
+using namespace std;
+
+class Pipeline : public TimingModel {
+
+    private:
+
+        // latencies in cycles
+        unsigned int load_use_latency;
+        unsigned int branch_penalty;
+        unsigned int jump_penalty;
+        unsigned int trap_latency;
+        unsigned int csr_latency;
+
+        // pipeline state
+        uint64_t next_fetch;        // cycle the next instruction enters IF
+        uint64_t last_ex;           // cycle the previous instruction left EX
+        uint64_t last_wb;           // cycle the previous instruction entered WB
+        uint64_t reg_ready[reg_slots];  // first cycle each register can be bypassed to EX
+
+        // statistics
+        uint64_t instructions;
+        uint64_t load_use_stalls;
+        uint64_t branch_stalls;
+        uint64_t jump_stalls;
+        uint64_t trap_stalls;
+        uint64_t csr_stalls;
+        uint64_t fetch_stalls;
+        uint64_t mem_stalls;
+
+    public:
+
+        // Constructor
+        Pipeline(unsigned int load_use_latency, unsigned int branch_penalty, unsigned int jump_penalty,
+                 unsigned int trap_latency, unsigned int csr_latency);
+
+        // advance the pipeline by one retired instruction
+        void retire(const RetiredIns& rec) override;
+
+        // return cycles until the last retired instruction leaves WB
+        uint64_t getCycles() override;
+
+        // print stall breakdown
+        void printStats() override;
+
+        // destructor
+        ~Pipeline();
+};
+
+#endif
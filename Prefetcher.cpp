@@ -0,0 +1,188 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Classes for hardware prefetcher models
+**************************************************************** */
+
+#include "Prefetcher.h"
+
+// Constructor
+Prefetcher::Prefetcher(string name)
+{
+    this->name = name;
+    line_bits = 6;
+}
+
+// create a prefetcher by name, NULL if unknown
+Prefetcher* Prefetcher::create(string name)
+{
+    if (name == "next") return new NextLinePrefetcher(1);
+    if (name == "stride") return new StridePrefetcher(2);
+    if (name == "stream") return new StreamPrefetcher(4);
+    return NULL;
+}
+
+// set line size of the cache being prefetched into
+void Prefetcher::setLineSize(unsigned int line_size)
+{
+    line_bits = 0;
+    while ((1u << line_bits) < line_size) line_bits++;
+}
+
+// return prefetcher name
+string Prefetcher::getName()
+{
+    return name;
+}
+
+// destructor
+Prefetcher::~Prefetcher()
+{
+
+}
+
+/* ****************************************************************
+   Next line
+**************************************************************** */
+
+NextLinePrefetcher::NextLinePrefetcher(unsigned int degree) : Prefetcher("next")
+{
+    this->degree = degree;
+}
+
+void NextLinePrefetcher::observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines)
+{
+    if (!trigger) return;
+    uint64_t line = address >> line_bits;
+    for (unsigned int i = 1; i <= degree; i++) lines.push_back(line + i);
+}
+
+/* ****************************************************************
+   Stride
+**************************************************************** */
+
+StridePrefetcher::StridePrefetcher(unsigned int degree) : Prefetcher("stride")
+{
+    this->degree = degree;
+    Entry empty = {UINT64_MAX, 0, 0, 0};
+    table.assign(1u << table_bits, empty);
+}
+
+void StridePrefetcher::observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines)
+{
+    Entry& entry = table[(pc >> 2) & ((1u << table_bits) - 1)];
+
+    // new instruction in this slot
+    if (entry.pc != pc)
+    {
+        entry.pc = pc;
+        entry.last_address = address;
+        entry.stride = 0;
+        entry.confidence = 0;
+        return;
+    }
+
+    // confirm or retrain the stride
+    int64_t delta = (int64_t)(address - entry.last_address);
+    entry.last_address = address;
+    if (delta == 0) return;
+    if (delta == entry.stride)
+    {
+        if (entry.confidence < 3) entry.confidence++;
+    }
+    else if (entry.confidence > 0)
+    {
+        entry.confidence--;
+    }
+    else
+    {
+        entry.stride = delta;
+    }
+    if (entry.confidence < 2) return;
+
+    // strides within a line step a line at a time
+    uint64_t line = address >> line_bits;
+    int64_t line_size = (int64_t)1 << line_bits;
+    for (unsigned int i = 1; i <= degree; i++)
+    {
+        if (entry.stride < line_size && entry.stride > -line_size)
+        {
+            lines.push_back(entry.stride > 0 ? line + i : line - i);
+        }
+        else
+        {
+            lines.push_back((address + entry.stride * i) >> line_bits);
+        }
+    }
+}
+
+/* ****************************************************************
+   Stream
+**************************************************************** */
+
+StreamPrefetcher::StreamPrefetcher(unsigned int depth) : Prefetcher("stream")
+{
+    this->depth = depth;
+    clock = 0;
+    for (unsigned int i = 0; i < num_streams; i++)
+    {
+        Stream empty = {UINT64_MAX, 0, 0, 0, 0};
+        streams[i] = empty;
+    }
+}
+
+void StreamPrefetcher::observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines)
+{
+    if (!trigger) return;
+    uint64_t line = address >> line_bits;
+    clock++;
+
+    // find a stream near this line, or replace the least recently used
+    unsigned int found = num_streams;
+    unsigned int lru = 0;
+    for (unsigned int i = 0; i < num_streams; i++)
+    {
+        if (streams[i].last_line != UINT64_MAX &&
+            line + window >= streams[i].last_line && line <= streams[i].last_line + window)
+        {
+            found = i;
+            break;
+        }
+        if (streams[i].stamp < streams[lru].stamp) lru = i;
+    }
+    if (found == num_streams)
+    {
+        Stream fresh = {line, line, 0, 0, clock};
+        streams[lru] = fresh;
+        return;
+    }
+
+    Stream& stream = streams[found];
+    stream.stamp = clock;
+    if (line == stream.last_line) return;
+
+    // train direction, then confirm it
+    int direction = line > stream.last_line ? 1 : -1;
+    if (stream.direction == direction)
+    {
+        if (stream.confidence < 3) stream.confidence++;
+    }
+    else
+    {
+        stream.direction = direction;
+        stream.confidence = 0;
+        stream.head = line;
+    }
+    stream.last_line = line;
+    if (stream.confidence < 1) return;
+
+    // run ahead of the stream up to depth lines
+    for (unsigned int i = 1; i <= depth; i++)
+    {
+        uint64_t target = direction > 0 ? line + i : line - i;
+        if (direction > 0 ? target > stream.head : target < stream.head)
+        {
+            lines.push_back(target);
+            stream.head = target;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Classes for hardware prefetcher models
+**************************************************************** */
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+// base class for prefetchers, producing line addresses
+class Prefetcher {
+
+    protected:
+
+        string name;
+        unsigned int line_bits;
+
+    public:
+
+        // Constructor
+        Prefetcher(string name);
+
+        // create a prefetcher by name ("next", "stride" or "stream"), NULL if unknown
+        static Prefetcher* create(string name);
+
+        // set line size of the cache being prefetched into
+        void setLineSize(unsigned int line_size);
+
+        // observe a demand access to address by the instruction at pc and append lines to prefetch
+        // trigger is set on a miss or on the first use of a prefetched line
+        virtual void observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines) = 0;
+
+        // return prefetcher name
+        string getName();
+
+        // destructor
+        virtual ~Prefetcher();
+};
+
+// fetch the following lines on a trigger
+class NextLinePrefetcher : public Prefetcher {
+
+    private:
+
+        unsigned int degree;
+
+    public:
+
+        NextLinePrefetcher(unsigned int degree);
+        void observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines) override;
+};
+
+// per-instruction stride detection in a pc indexed table
+class StridePrefetcher : public Prefetcher {
+
+    private:
+
+        struct Entry
+        {
+            uint64_t pc;
+            uint64_t last_address;
+            int64_t stride;         // in bytes
+            uint8_t confidence;     // 2-bit
+        };
+
+        static const unsigned int table_bits = 8;
+
+        vector<Entry> table;
+        unsigned int degree;
+
+    public:
+
+        StridePrefetcher(unsigned int degree);
+        void observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines) override;
+};
+
+// sequential stream detection over triggering accesses, ascending or descending
+class StreamPrefetcher : public Prefetcher {
+
+    private:
+
+        struct Stream
+        {
+            uint64_t last_line;
+            uint64_t head;          // furthest line prefetched
+            int direction;          // +1, -1 or 0 while training
+            uint8_t confidence;
+            uint64_t stamp;         // LRU replacement
+        };
+
+        static const unsigned int num_streams = 8;
+        static const unsigned int window = 4;   // lines either side of last_line that match a stream
+
+        Stream streams[num_streams];
+        unsigned int depth;
+        uint64_t clock;
+
+    public:
+
+        StreamPrefetcher(unsigned int depth);
+        void observe(uint64_t pc, uint64_t address, bool trigger, vector<uint64_t>& lines) override;
+};
+
+#endif
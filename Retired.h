@@ -0,0 +1,34 @@
+#ifndef RETIRED_H
+#define RETIRED_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Retired instruction record
+**************************************************************** */
+
+#include <cstdint>
+#include "Instruction.h"
+
+using namespace RV64I;
+
+// record of one instruction passed from the functional core to timing models
+struct RetiredIns
+{
+    uint64_t pc;            // address of the instruction
+    uint64_t next_pc;       // address of the next instruction executed
+    uint64_t mem_addr;      // effective address of loads and stores
+    uint32_t ins;           // instruction word, expanded if compressed
+    uint8_t len;            // instruction length in bytes, 2 if compressed
+    Ins code;               // instruction code
+    char type;              // instruction type (capital letter)
+    uint8_t rd;             // dest register
+    uint8_t rs1;            // source register 1
+    uint8_t rs2;            // source register 2
+    bool trap;              // a trap was taken on this instruction
+    uint32_t fetch_penalty; // instruction cache miss cycles
+    uint32_t mem_penalty;   // data cache miss cycles
+    bool predicted;         // control transfer evaluated by a branch predictor
+    bool mispredict;        // direction or target mispredicted
+};
+
+#endif
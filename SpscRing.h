@@ -0,0 +1,76 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for lock-free single-producer single-consumer ring
+**************************************************************** */
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+template <typename T>
+class SpscRing {
+
+    private:
+
+        vector<T> slots;
+        size_t mask;
+
+        // each index is written by one side only, padded onto separate cache lines
+        char pad0[64];
+        atomic<size_t> head;                // next slot to write, owned by the producer
+        size_t cached_tail;                 // producer's copy of tail
+        char pad1[64];
+        atomic<size_t> tail;                // next slot to read, owned by the consumer
+        size_t cached_head;                 // consumer's copy of head
+        char pad2[64];
+
+    public:
+
+        // Constructor, capacity rounded up to a power of two
+        SpscRing(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            slots.resize(size);
+            mask = size - 1;
+            head.store(0, memory_order_relaxed);
+            tail.store(0, memory_order_relaxed);
+            cached_tail = 0;
+            cached_head = 0;
+        }
+
+        // producer: append an item, false when full
+        bool push(const T& item)
+        {
+            size_t h = head.load(memory_order_relaxed);
+            if (h - cached_tail > mask)
+            {
+                cached_tail = tail.load(memory_order_acquire);
+                if (h - cached_tail > mask) return false;
+            }
+            slots[h & mask] = item;
+            head.store(h + 1, memory_order_release);
+            return true;
+        }
+
+        // consumer: remove the oldest item, false when empty
+        bool pop(T& item)
+        {
+            size_t t = tail.load(memory_order_relaxed);
+            if (t == cached_head)
+            {
+                cached_head = head.load(memory_order_acquire);
+                if (t == cached_head) return false;
+            }
+            item = slots[t & mask];
+            tail.store(t + 1, memory_order_release);
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,181 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Base class for timing models
+**************************************************************** */
+
+#include "TimingModel.h"
+
+// Constructor
+TimingModel::TimingModel()
+{
+    trace = NULL;
+}
+
+// write per-instruction stage cycles to a trace
+void TimingModel::setTrace(KonataTrace* trace)
+{
+    this->trace = trace;
+}
+
+// return true for load instructions, atomics included as they return a value
+bool TimingModel::isLoad(Ins code)
+{
+    return code == ins_lb || code == ins_lh || code == ins_lw || code == ins_ld ||
+           code == ins_lbu || code == ins_lhu || code == ins_lwu ||
+           code == ins_flw || code == ins_fld ||
+           (code >= ins_lr_w && code <= ins_amomaxu_d) ||
+           (code >= ins_vle8_v && code <= ins_vlse64_v);
+}
+
+// return true for store instructions
+bool TimingModel::isStore(Ins code)
+{
+    return code == ins_sb || code == ins_sh || code == ins_sw || code == ins_sd ||
+           code == ins_fsw || code == ins_fsd ||
+           (code >= ins_vse8_v && code <= ins_vsse64_v);
+}
+
+// return true for conditional branches
+bool TimingModel::isBranch(Ins code)
+{
+    return code >= ins_beq && code <= ins_bgeu;
+}
+
+// return true for csr instructions
+bool TimingModel::isCsr(Ins code)
+{
+    return code >= ins_csrrw && code <= ins_csrrci;
+}
+
+// return true for instructions without register operands
+bool TimingModel::isSystem(Ins code)
+{
+    return code == ins_default || code == ins_fence || code == ins_ecall ||
+           code == ins_ebreak || code == ins_mret || code == ins_sret || code == ins_wfi;
+}
+
+// register file of each operand, by instruction code for floating point and vectors and by type otherwise
+void TimingModel::operandFiles(const RetiredIns& rec, RegFile& rd, RegFile& rs1, RegFile& rs2, RegFile& rs3)
+{
+    Ins code = rec.code;
+    rd = rs1 = rs2 = rs3 = file_none;
+
+    if (code >= ins_flw && code <= ins_fmv_d_x)
+    {
+        switch (code)
+        {
+            case ins_flw: case ins_fld:
+                rd = file_f; rs1 = file_x;
+                break;
+            case ins_fsw: case ins_fsd:
+                rs1 = file_x; rs2 = file_f;
+                break;
+            case ins_fmadd_s: case ins_fmsub_s: case ins_fnmsub_s: case ins_fnmadd_s:
+            case ins_fmadd_d: case ins_fmsub_d: case ins_fnmsub_d: case ins_fnmadd_d:
+                rd = rs1 = rs2 = rs3 = file_f;
+                break;
+            case ins_fsqrt_s: case ins_fsqrt_d: case ins_fcvt_s_d: case ins_fcvt_d_s:
+                rd = rs1 = file_f;
+                break;
+            case ins_fcvt_w_s: case ins_fcvt_wu_s: case ins_fcvt_l_s: case ins_fcvt_lu_s:
+            case ins_fcvt_w_d: case ins_fcvt_wu_d: case ins_fcvt_l_d: case ins_fcvt_lu_d:
+            case ins_fclass_s: case ins_fclass_d: case ins_fmv_x_w: case ins_fmv_x_d:
+                rd = file_x; rs1 = file_f;
+                break;
+            case ins_fcvt_s_w: case ins_fcvt_s_wu: case ins_fcvt_s_l: case ins_fcvt_s_lu:
+            case ins_fcvt_d_w: case ins_fcvt_d_wu: case ins_fcvt_d_l: case ins_fcvt_d_lu:
+            case ins_fmv_w_x: case ins_fmv_d_x:
+                rd = file_f; rs1 = file_x;
+                break;
+            case ins_feq_s: case ins_flt_s: case ins_fle_s:
+            case ins_feq_d: case ins_flt_d: case ins_fle_d:
+                rd = file_x; rs1 = rs2 = file_f;
+                break;
+            default:
+                rd = rs1 = rs2 = file_f;
+                break;
+        }
+        return;
+    }
+
+    if (code >= ins_vsetvli && code <= ins_vredmax_vs)
+    {
+        unsigned int funct3 = (rec.ins >> 12) & 0x7;
+        if (code == ins_vsetvli) { rd = rs1 = file_x; }
+        else if (code == ins_vsetivli) { rd = file_x; }
+        else if (code == ins_vsetvl) { rd = rs1 = rs2 = file_x; }
+        else if (code >= ins_vle8_v && code <= ins_vlse64_v)
+        {
+            // strided forms take the stride in rs2
+            rd = file_v; rs1 = file_x;
+            if (code >= ins_vlse8_v) rs2 = file_x;
+        }
+        else if (code >= ins_vse8_v && code <= ins_vsse64_v)
+        {
+            // the data is vs3, encoded in rd
+            rs1 = file_x; rs3 = file_v;
+            if (code >= ins_vsse8_v) rs2 = file_x;
+        }
+        else if (code == ins_vmv_x_s) { rd = file_x; rs2 = file_v; }
+        else if (code == ins_vmv_s_x) { rd = file_v; rs1 = file_x; }
+        else
+        {
+            // vs1 for .vv and .vs, a scalar for .vx and nothing for .vi, and vs2 except in vmv.v
+            rd = file_v;
+            if (funct3 == 0 || funct3 == 2) rs1 = file_v;
+            else if (funct3 == 4 || funct3 == 6) rs1 = file_x;
+            if (code < ins_vmv_v_v || code > ins_vmv_v_i) rs2 = file_v;
+            if (code == ins_vmacc_vv || code == ins_vmacc_vx) rs3 = file_v;
+        }
+        return;
+    }
+
+    // R, S and B types read rs1, and so does I type except csr immediates (zimm in rs1)
+    if (isSystem(code)) return;
+    if ((rec.type == 'R' || rec.type == 'S' || rec.type == 'B' || rec.type == 'I') &&
+        !(code >= ins_csrrwi && code <= ins_csrrci)) rs1 = file_x;
+
+    // R, S and B types read rs2, and R, I, U and J types write rd
+    if (rec.type == 'R' || rec.type == 'S' || rec.type == 'B') rs2 = file_x;
+    if (rec.type == 'R' || rec.type == 'I' || rec.type == 'U' || rec.type == 'J') rd = file_x;
+}
+
+// scoreboard slot of a register, x0 having none
+bool TimingModel::regSlot(RegFile file, unsigned int reg, unsigned int& slot)
+{
+    if (file == file_none || (file == file_x && reg == 0)) return false;
+    slot = (file - file_x) * 32 + reg;
+    return true;
+}
+
+// registers read, with v0 added for masked vector instructions, returning the count
+unsigned int TimingModel::sourceRegs(const RetiredIns& rec, unsigned int slots[4])
+{
+    RegFile rd, rs1, rs2, rs3;
+    operandFiles(rec, rd, rs1, rs2, rs3);
+
+    // rs3 is ins[31:27] for fused multiply-adds, otherwise a vd that is also read
+    unsigned int count = 0;
+    if (regSlot(rs1, (rec.ins >> 15) & 0x1f, slots[count])) count++;
+    if (regSlot(rs2, (rec.ins >> 20) & 0x1f, slots[count])) count++;
+    if (regSlot(rs3, rs3 == file_f ? rec.ins >> 27 : (rec.ins >> 7) & 0x1f, slots[count])) count++;
+    if (rec.code >= ins_vle8_v && rec.code <= ins_vredmax_vs && ((rec.ins >> 25) & 0x1) == 0)
+    {
+        if (regSlot(file_v, 0, slots[count])) count++;
+    }
+    return count;
+}
+
+// register written
+bool TimingModel::destReg(const RetiredIns& rec, unsigned int& slot)
+{
+    RegFile rd, rs1, rs2, rs3;
+    operandFiles(rec, rd, rs1, rs2, rs3);
+    return regSlot(rd, (rec.ins >> 7) & 0x1f, slot);
+}
+
+// destructor
+TimingModel::~TimingModel()
+{
+
+}
@@ -0,0 +1,64 @@
+#ifndef TIMINGMODEL_H
+#define TIMINGMODEL_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Base class for timing models
+**************************************************************** */
+
+#include <cstdint>
+#include "Retired.h"
+#include "KonataTrace.h"
+
+using namespace std;
+
+class TimingModel {
+
+    public:
+
+        // instruction classification
+        static bool isLoad(Ins code);
+        static bool isStore(Ins code);
+        static bool isBranch(Ins code);
+        static bool isCsr(Ins code);
+        static bool isSystem(Ins code);
+
+    protected:
+
+        // pipeline trace, NULL when disabled
+        KonataTrace* trace;
+
+        // scoreboard slots, x registers at 0-31, f registers at 32-63 and v registers at 64-95
+        static const unsigned int reg_slots = 96;
+
+        // registers read and written by an instruction as scoreboard slots, x0 left out
+        static unsigned int sourceRegs(const RetiredIns& rec, unsigned int slots[4]);
+        static bool destReg(const RetiredIns& rec, unsigned int& slot);
+
+        // register file of each operand, rs3 being the fused multiply-add rs3 or a vd that is read
+        enum RegFile { file_none, file_x, file_f, file_v };
+        static void operandFiles(const RetiredIns& rec, RegFile& rd, RegFile& rs1, RegFile& rs2, RegFile& rs3);
+        static bool regSlot(RegFile file, unsigned int reg, unsigned int& slot);
+
+    public:
+
+        // Constructor
+        TimingModel();
+
+        // write per-instruction stage cycles to a trace
+        void setTrace(KonataTrace* trace);
+
+        // advance the model by one retired instruction
+        virtual void retire(const RetiredIns& rec) = 0;
+
+        // return cycles until the last retired instruction completes
+        virtual uint64_t getCycles() = 0;
+
+        // print model statistics
+        virtual void printStats() = 0;
+
+        // destructor
+        virtual ~TimingModel();
+};
+
+#endif
@@ -0,0 +1,89 @@
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for running timing models on a separate host thread
+**************************************************************** */
+
+#include "TimingThread.h"
+#include <iostream>
+#include <chrono>
+
+// Constructor, starts the consumer thread
+TimingThread::TimingThread(TimingModel* timing, BranchUnit* branch_unit, size_t capacity) : ring(capacity)
+{
+    this->timing = timing;
+    this->branch_unit = branch_unit;
+    stopping.store(false);
+    published = 0;
+    completed.store(0);
+    full_waits = 0;
+    worker = thread(&TimingThread::run, this);
+}
+
+// consumer loop
+void TimingThread::run()
+{
+    RetiredIns rec;
+    unsigned int idle = 0;
+    while (true)
+    {
+        if (ring.pop(rec))
+        {
+            idle = 0;
+            rec.predicted = branch_unit != NULL;
+            rec.mispredict = branch_unit != NULL && branch_unit->resolve(rec);
+            if (timing != NULL) timing->retire(rec);
+            completed.store(completed.load(memory_order_relaxed) + 1, memory_order_release);
+        }
+        else if (stopping.load(memory_order_acquire))
+        {
+            break;
+        }
+        else if (++idle < 1024)
+        {
+            this_thread::yield();
+        }
+        else
+        {
+            // back off while the producer is idle, e.g. at the command prompt
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+}
+
+// publish a retired instruction, waiting while the ring is full
+void TimingThread::publish(const RetiredIns& rec)
+{
+    if (!ring.push(rec))
+    {
+        full_waits++;
+        while (!ring.push(rec)) this_thread::yield();
+    }
+    published++;
+}
+
+// wait until every published record has been consumed
+void TimingThread::drain()
+{
+    while (completed.load(memory_order_acquire) != published) this_thread::yield();
+}
+
+// drain and join the consumer thread
+void TimingThread::stop()
+{
+    if (!worker.joinable()) return;
+    drain();
+    stopping.store(true, memory_order_release);
+    worker.join();
+}
+
+// print ring statistics
+void TimingThread::printStats()
+{
+    cout << "Timing thread records: " << dec << published << ", producer waits on full ring: " << full_waits << endl;
+}
+
+// destructor
+TimingThread::~TimingThread()
+{
+    stop();
+}
@@ -0,0 +1,65 @@
+#ifndef TIMINGTHREAD_H
+#define TIMINGTHREAD_H
+
+/* ****************************************************************
+   RISC-V Instruction Set Simulator
+   Class for running timing models on a separate host thread
+**************************************************************** */
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+
+#include "Retired.h"
+#include "SpscRing.h"
+#include "TimingModel.h"
+#include "BranchUnit.h"
+
+using namespace std;
+
+class TimingThread {
+
+    private:
+
+        // consumers of retired instructions, either may be NULL
+        TimingModel* timing;
+        BranchUnit* branch_unit;
+
+        SpscRing<RetiredIns> ring;
+        thread worker;
+        atomic<bool> stopping;
+
+        // records published by the producer and completed by the consumer, each written
+        // for every record so padded onto separate cache lines like the ring indices
+        char pad0[64];
+        uint64_t published;
+        uint64_t full_waits;                // producer waits on a full ring
+        char pad1[64];
+        atomic<uint64_t> completed;
+        char pad2[64];
+
+        // consumer loop
+        void run();
+
+    public:
+
+        // Constructor, starts the consumer thread
+        TimingThread(TimingModel* timing, BranchUnit* branch_unit, size_t capacity);
+
+        // publish a retired instruction, waiting while the ring is full
+        void publish(const RetiredIns& rec);
+
+        // wait until every published record has been consumed
+        void drain();
+
+        // drain and join the consumer thread
+        void stop();
+
+        // print ring statistics
+        void printStats();
+
+        // destructor
+        ~TimingThread();
+};
+
+#endif
@@ -40,6 +40,16 @@ bool command_match_decimal_number(string& command, unsigned int& i, unsigned int
 }
 
 
+bool command_match_decimal_number(string& command, unsigned int& i, uint64_t& num) {
+  unsigned int j = i;
+  while (j < command.length() && isdigit(command[j])) j++;
+  if (j == i) return false;
+  stringstream(command.substr(i, j - i)) >> num;
+  i = j;
+  return true;
+}
+
+
 bool command_match_hex_number(string& command, unsigned int& i, uint64_t& num) {
   unsigned int j = i;
   while (j < command.length() && isxdigit(command[j])) j++;
@@ -108,7 +118,7 @@ bool command_match_m(string& command, unsigned int i, bool& data_present, uint64
 }
 
 
-bool command_match_dot(string& command, unsigned int i, bool& num_present, unsigned int& num) {
+bool command_match_dot(string& command, unsigned int i, bool& num_present, uint64_t& num) {
   num_present = false;
   if (i == command.length() || command[i] != '.') return false;
   i++;
@@ -196,6 +206,51 @@ bool command_match_csr(string& command, unsigned int i, bool& data_present, uint
 }
 
 
+bool command_match_run(string& command, unsigned int i) {
+  if (i == command.length() || command[i] != 'r') return false;
+  i++;
+  if (i == command.length() || command[i] != 'u') return false;
+  i++;
+  if (i == command.length() || command[i] != 'n') return false;
+  i++;
+  command_skip_optional_whitespace(command, i);
+  return i == command.length() || command[i] == '#';
+}
+
+
+bool command_match_halt(string& command, unsigned int i, string& condition, uint64_t& value) {
+  unsigned int j;
+  condition = "";
+  if (i == command.length() || command[i] != 'h') return false;
+  i++;
+  if (i == command.length() || command[i] != 'a') return false;
+  i++;
+  if (i == command.length() || command[i] != 'l') return false;
+  i++;
+  if (i == command.length() || command[i] != 't') return false;
+  i++;
+  if (i == command.length() || command[i] == '#') return true;
+  if (!command_skip_required_whitespace(command, i)) return false;
+  j = i;
+  while (j < command.length() && isalpha(command[j])) j++;
+  condition = command.substr(i, j - i);
+  i = j;
+  if (condition == "ecall" || condition == "tohost") {  // hex value
+    if (!command_skip_required_whitespace(command, i)) return false;
+    if (!command_match_hex_number(command, i, value)) return false;
+  }
+  else if (condition == "count" || condition == "time") {  // decimal value
+    if (!command_skip_required_whitespace(command, i)) return false;
+    if (!command_match_decimal_number(command, i, value)) return false;
+  }
+  else if (condition != "ebreak") {
+    return false;
+  }
+  command_skip_optional_whitespace(command, i);
+  return i == command.length() || command[i] == '#';
+}
+
+
 // Command interpreter function
 void interpret_commands(memory* main_memory, processor* cpu, bool verbose) {
 
@@ -204,7 +259,9 @@ void interpret_commands(memory* main_memory, processor* cpu, bool verbose) {
   bool address_present, data_present, num_present;
   uint64_t address, data;
   unsigned int num;
+  uint64_t count;
   string filename;
+  string condition;
 
   while (true) {
     getline(cin, command);  // Read the next line of input
@@ -242,12 +299,12 @@ void interpret_commands(memory* main_memory, processor* cpu, bool verbose) {
         main_memory->write_doubleword(address, data, 0xffffffffffffffffULL);
       }
     }
-    else if (command_match_dot(command, i, num_present, num)) {  // Check for . command
+    else if (command_match_dot(command, i, num_present, count)) {  // Check for . command
       if (!num_present) {  // No instruction count value
         cpu->execute(1, false);  // so just execute one instruction without breakpoint check
       }
       else {
-        cpu->execute(num, true);  // Execute specified number of instructions with breakpoint check
+        cpu->execute(count, true);  // Execute specified number of instructions with breakpoint check
       }
     }
     else if (command_match_b(command, i, address_present, address)) {  // Check for b command
@@ -267,7 +324,7 @@ void interpret_commands(memory* main_memory, processor* cpu, bool verbose) {
     else if (command_match_prv(command, i, num_present, num)) {  // Check for prv command
       if (!num_present) { // No new privilege level
         cpu->show_prv();  // so just show current privilege level
-      } else if (num == 0 || num == 3) {
+      } else if (num == 0 || num == 1 || num == 3) {
         cpu->set_prv(num);  // Set the current privilege level
       } else {
         cout << "Incorrect privilege level" << endl;
@@ -284,6 +341,29 @@ void interpret_commands(memory* main_memory, processor* cpu, bool verbose) {
         cpu->set_csr(address, data);  // Update memory word
       }
     }
+    else if (command_match_run(command, i)) {  // Check for run command
+      cpu->run();  // Execute until breakpoint or halt condition
+    }
+    else if (command_match_halt(command, i, condition, data)) {  // Check for halt command
+      if (condition == "") {  // No condition
+        cpu->clear_halt();  // so just clear halt conditions
+      }
+      else if (condition == "ebreak") {
+        cpu->set_halt_ebreak();
+      }
+      else if (condition == "ecall") {
+        cpu->set_halt_ecall(data);
+      }
+      else if (condition == "tohost") {
+        cpu->set_halt_tohost(data);
+      }
+      else if (condition == "count") {
+        cpu->set_halt_count(data);
+      }
+      else {
+        cpu->set_halt_time(data);
+      }
+    }
     else {
       cout << "Unrecognized command" << endl;
     }
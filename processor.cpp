@@ -5,7 +5,18 @@
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <cfenv>
+#include <limits>
+#include <type_traits>
 #include "processor.h"
+#include "Isa.h"
+
+// host 128-bit arithmetic for the high half of multiplies
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
 
 // Constructor
 processor::processor(memory* main_memory, bool verbose, bool stage2)
@@ -21,14 +32,82 @@ processor::processor(memory* main_memory, bool verbose, bool stage2)
     bp_enabled = false;
     ins_count = 0;
 
+    // initialise halt conditions
+    clear_halt();
+    halted = false;
+    running = false;
+    host_seconds = 0;
+
     // initialise decoder
     decoder = new Decoder(verbose);
 
+    // timing model disabled by default
+    timing = NULL;
+    trapped = false;
+
+    // cache models disabled by default
+    icache = NULL;
+    dcache = NULL;
+    mem_penalty = 0;
+    sweep = NULL;
+
+    // branch prediction disabled by default
+    branch_unit = NULL;
+    timing_thread = NULL;
+
+    // cycle estimate disabled by default
+    cost_model = NULL;
+
+    // no devices
+    events = new EventQueue ();
+    clint = NULL;
+    clint_generation = 0;
+    idle_ticks = 0;
+
+    // spin loop skipping disabled by default
+    skip_spin_enabled = false;
+    spin_branch = UINT64_MAX;
+    spin_target = 0;
+    spin_start = 0;
+    spin_dirty = true;
+    spin_skipped = 0;
+
+    // no lr reservation
+    reserved = false;
+    reservation = 0;
+
+    // counters start from zero
+    loads = 0;
+    stores = 0;
+    branches_taken = 0;
+    traps = 0;
+    for (int i = 0; i < 32; i++) counter_base[i] = 0;
+
+    // empty TLBs
+    memset(tlb, 0, sizeof(tlb));
+    tlb_hits = 0;
+    tlb_misses = 0;
+    page_walks = 0;
+    paging = false;
+    access_fault = false;
+
+    // no pmp entries active
+    memset(pmp_regions, 0, sizeof(pmp_regions));
+    memset(pmp_cache, 0, sizeof(pmp_cache));
+    pmp_active = false;
+    pmp_locked = false;
+
     // initialise register values to zero
     for (int i = 0; i < 32; i++)
     {
         registers[i] = 0;
+        fregisters[i] = 0;
     }
+    host_round = 0;
+
+    // 128-bit vector registers by default
+    vlenb = 16;
+    vregisters.assign(32 * vlenb, 0);
 
     // initialise stage 2 variables
     prv = 3;            // privilege level default 3
@@ -57,77 +136,87 @@ void processor::show_reg(unsigned int reg_num)
 // Set register to new value
 void processor::set_reg(unsigned int reg_num, uint64_t new_value)
 {
-    // ignore x0
-    if (reg_num == 0) return;
+    // ignore x0, and results of an instruction that faulted on a memory access
+    if (reg_num == 0 || access_fault) return;
     registers[reg_num] = new_value;
 }
 
 // Execute a number of instructions
-void processor::execute(unsigned int num, bool breakpoint_check)
+void processor::execute(uint64_t num, bool breakpoint_check)
 {
-    for (unsigned int i = 0; i < num; i++)
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    RetiredIns rec;
+    bool tracing = timing != NULL || branch_unit != NULL;
+    halted = false;
+
+    // spin skipping advances i by arbitrary amounts, so the wall-clock check uses a threshold
+    uint64_t next_check = 0xffff;
+
+    // host flags raised outside guest instructions are not guest exceptions
+    feclearexcept(FE_ALL_EXCEPT);
+
+    for (uint64_t i = 0; i < num; i++)
     {
-        // check for pc alignment
-        if (pc % 4 != 0)
+        // check for pc alignment, compressed instructions allow halfword boundaries
+        if (pc % (Isa::c ? 2 : 4) != 0)
         {
-            except(0);
+            except(0, pc);
         }
         else
         {
+            trapped = false;
+
+            // the next event deadline is the only per-instruction device check
+            if (ticks() >= events->nextDeadline()) service_events();
+
             // check for interrupt, orderred by priority
-            // mstatus.mie == 1 or in user mode
-            if(((csrs[0x300] >> 3) & 0x1) == 1 || prv == 0)
-            {
-                if(((csrs[0x344] >> 11) & 0x1) == 1 && ((csrs[0x304] >> 11) & 0x1) == 1)
-                {
-                    // machine external interrupt
-                    // (mip.meip && mie.meie) && mstatus.mie
-                    interrupt(11);
-                }
-                else if(((csrs[0x344] >> 3) & 0x1) == 1 && ((csrs[0x304] >> 3) & 0x1) == 1)
-                {
-                    // machine software interrupt
-                    // (mip.msip && mie.msie) && mstatus.mie
-                    interrupt(3);
-                }
-                else if(((csrs[0x344] >> 7) & 0x1) == 1 && ((csrs[0x304] >> 7) & 0x1) == 1)
-                {
-                    // machine timer interrupt
-                    // (mip.mtip && mie.mtie) && mstatus.mie
-                    interrupt(7);
-                }
-                else if(((csrs[0x344] >> 8) & 0x1) == 1 && ((csrs[0x304] >> 8) & 0x1) == 1)
+            // interrupts not delegated in mideleg are taken in machine mode when mstatus.mie is set or from a lower mode,
+            // delegated ones in supervisor mode when mstatus.sie is set or from user mode
+            uint64_t pending = csrs[0x344] & csrs[0x304];
+            if (pending != 0)
+            {
+                static const int priority[] = {11, 3, 7, 9, 1, 5, 8, 0, 4};
+                uint64_t enabled = 0;
+                if (((csrs[0x300] >> 3) & 0x1) == 1 || prv < 3) enabled |= pending & ~csrs[0x303];
+                if ((((csrs[0x300] >> 1) & 0x1) == 1 && prv == 1) || prv == 0) enabled |= pending & csrs[0x303];
+                for (int cause : priority)
                 {
-                    // user external interrupt
-                    // (mip.ueip && mie.ueie) && mstatus.mie
-                    interrupt(8);
-                }
-                else if((csrs[0x344] & 0x1) == 1 && (csrs[0x304] & 0x1) == 1)
-                {
-                    // user software interrupt
-                    // (mip.usip && mie.usie) && mstatus.mie
-                    interrupt(0);
-                }  
-                else if(((csrs[0x344] >> 4) & 0x1) == 1 && ((csrs[0x304] >> 4) & 0x1) == 1)
-                {
-                    // user timer interrupt
-                    // (mip.utip && mie.utie) && mstatus.mie
-                    interrupt(4);
+                    if ((enabled >> cause) & 0x1)
+                    {
+                        interrupt(cause);
+                        break;
+                    }
                 }
             }
 
-            // fetch instruction from memory
-            uint64_t data = main_memory->read_doubleword(pc);
-            uint32_t ins;
-            if (pc % 8 != 0)
+            // fetch instruction from memory, a page or access fault traps before the instruction
+            uint64_t fetch_address = pc;
+            if ((paging && !translate(pc, 0, fetch_address)) || (pmp_active && !pmp_check(pc, fetch_address, 0)))
             {
-                // first half of data
-                ins = (data >> 32) & 0xffffffff;
+                access_fault = false;
+                continue;
             }
-            else
+            uint64_t data = main_memory->read_doubleword(fetch_address);
+            rec.fetch_penalty = 0;
+            if (icache != NULL)
             {
-                // second half of data
-                ins = data & 0xffffffff;
+                icache->setTime(cache_time());
+                rec.fetch_penalty = icache->access(fetch_address,false);
+            }
+            if (sweep != NULL) sweep->access(fetch_address,true);
+            uint32_t ins = (data >> ((pc % 8) * 8)) & 0xffffffff;
+            if (pc % 8 == 6 && (ins & 0x3) == 0x3)
+            {
+                // a 32-bit instruction straddling two doublewords takes its upper half from the next,
+                // which is on the next page at the end of a page
+                uint64_t next_address = fetch_address + 2;
+                if ((paging && (pc + 2) % 4096 == 0 && !translate(pc + 2, 0, next_address)) ||
+                    (pmp_active && !pmp_check(pc + 2, next_address, 0)))
+                {
+                    access_fault = false;
+                    continue;
+                }
+                ins |= (main_memory->read_doubleword(next_address) & 0xffff) << 16;
             }
 
             if (verbose)
@@ -140,18 +229,90 @@ void processor::execute(unsigned int num, bool breakpoint_check)
             if (breakpoint_check && (pc == breakpoint) && bp_enabled)
             {
                 cout << "Breakpoint reached at " << setw(16) << setfill('0') << hex << breakpoint << endl;
+                halted = true;
                 break;
             }
             else
             {
                 // decode
                 decoder->decodeIns(ins);
+                uint64_t ins_pc = pc;
+
+                // capture operands for the timing model before they are overwritten
+                if (tracing)
+                {
+                    rec.pc = pc;
+                    rec.ins = decoder->getIns();
+                    rec.len = decoder->getInsLength();
+                    rec.code = decoder->getInsCode();
+                    rec.type = decoder->getInsType();
+                    rec.rd = decoder->getRd();
+                    rec.rs1 = decoder->getRs1();
+                    rec.rs2 = decoder->getRs2();
+
+                    // lr, sc and amos have no immediate and address memory through rs1 alone
+                    rec.mem_addr = registers[decoder->getRs1()];
+                    if (rec.code < ins_lr_w || rec.code > ins_amomaxu_d) rec.mem_addr += sext_32_64(sext_12_32(decoder->getImm()));
+                }
+                mem_penalty = 0;
 
                 // execute
                 executeIns();
+                access_fault = false;
 
                 // increment instruction count
                 ins_count ++;
+
+                // count for the analytical estimate, halts leave the instruction unexecuted
+                if (cost_model != NULL && !(halted && pc == ins_pc))
+                {
+                    cost_model->count(decoder->getInsCode(), pc != ins_pc + decoder->getInsLength() && !trapped, trapped,
+                                      rec.fetch_penalty + mem_penalty);
+                }
+
+                // pass retired instruction to the branch predictors and timing model
+                // ebreak and ecall halts leave the instruction unexecuted
+                if (tracing && !(halted && pc == rec.pc))
+                {
+                    rec.next_pc = pc;
+                    rec.trap = trapped;
+                    rec.mem_penalty = mem_penalty;
+                    if (timing_thread != NULL)
+                    {
+                        timing_thread->publish(rec);
+                    }
+                    else
+                    {
+                        rec.predicted = branch_unit != NULL;
+                        rec.mispredict = branch_unit != NULL && branch_unit->resolve(rec);
+                        if (timing != NULL) timing->retire(rec);
+                    }
+                }
+
+                // loops of up to 16 instructions are checked at their backward transfer
+                if (skip_spin_enabled)
+                {
+                    if (trapped || decoder->getInsCode() == ins_mret) spin_dirty = true;
+                    if (pc <= ins_pc && pc + 64 >= ins_pc) i += skip_spin(ins_pc, num - i - 1);
+                }
+
+                // stop on halt condition
+                if (halted) break;
+            }
+
+            // check wall-clock budget every 64k instructions, keeping host arithmetic out of fflags
+            if (running && halt_time != 0 && i >= next_check)
+            {
+                next_check = i + 0x10000;
+                sync_fflags();
+                bool expired = chrono::duration<double>(chrono::steady_clock::now() - start).count() >= halt_time;
+                feclearexcept(FE_ALL_EXCEPT);
+                if (expired)
+                {
+                    cout << "Time limit reached at " << setw(16) << setfill('0') << hex << pc << endl;
+                    halted = true;
+                    break;
+                }
             }
             
             // cout << "x5: " << setw(16) << setfill('0') << registers[5];
@@ -160,6 +321,41 @@ void processor::execute(unsigned int num, bool breakpoint_check)
             // cout << ", x15: " << setw(16) << setfill('0') << registers[15] << endl;
         }
     }
+
+    // let the timing thread catch up so cycle counts are current
+    if (timing_thread != NULL) timing_thread->drain();
+
+    // collect guest fp flags and give the host its default rounding back
+    sync_fflags();
+    if (host_round != 0) set_round(0);
+
+    host_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Execute until a breakpoint or halt condition is reached
+void processor::run()
+{
+    uint64_t start_count = ins_count;
+    double start_seconds = host_seconds;
+    running = true;
+
+    if (halt_count != 0)
+    {
+        execute(halt_count, true);
+        if (!halted) cout << "Instruction limit reached at " << setw(16) << setfill('0') << hex << pc << endl;
+    }
+    else
+    {
+        execute(UINT64_MAX, true);
+    }
+    running = false;
+
+    // report host throughput for this run
+    uint64_t count = ins_count - start_count;
+    double seconds = host_seconds - start_seconds;
+    cout << "Run: " << dec << count << " instructions, " << seconds << " seconds";
+    if (seconds > 0) cout << ", " << count / seconds / 1e6 << " MIPS";
+    cout << endl;
 }
 
 // Clear breakpoint
@@ -173,11 +369,55 @@ void processor::clear_breakpoint()
 // Set breakpoint at an address
 void processor::set_breakpoint(uint64_t address)
 {
-    breakpoint = address - (address % 4);
+    breakpoint = address - (address % 2);
     bp_enabled = true;
     if (verbose) cout << "Breakpoint set at " << setw(16) << setfill('0') << hex << breakpoint << endl;
 }
 
+// Halt on ebreak
+void processor::set_halt_ebreak()
+{
+    halt_on_ebreak = true;
+}
+
+// Halt on ecall with a7 equal to value
+void processor::set_halt_ecall(uint64_t value)
+{
+    halt_on_ecall = true;
+    halt_ecall_a7 = value;
+}
+
+// Halt on a store to the tohost address
+void processor::set_halt_tohost(uint64_t address)
+{
+    halt_on_tohost = true;
+    tohost = address - (address % 8);
+}
+
+// Limit the number of instructions executed by run (0 = no limit)
+void processor::set_halt_count(uint64_t count)
+{
+    halt_count = count;
+}
+
+// Limit the host seconds spent by run (0 = no limit)
+void processor::set_halt_time(uint64_t seconds)
+{
+    halt_time = seconds;
+}
+
+// Clear all halt conditions
+void processor::clear_halt()
+{
+    halt_on_ebreak = false;
+    halt_on_ecall = false;
+    halt_ecall_a7 = 0;
+    halt_on_tohost = false;
+    tohost = 0;
+    halt_count = 0;
+    halt_time = 0;
+}
+
 // Show privilege level
 // Empty implementation for stage 1, required for stage 2
 void processor::show_prv()
@@ -189,6 +429,9 @@ void processor::show_prv()
         case 0:
             prv_str = "user";
             break;
+        case 1:
+            prv_str = "supervisor";
+            break;
         case 3:
             prv_str = "machine";
             break;
@@ -218,39 +461,245 @@ void processor::show_csr(unsigned int csr_num)
     else
     {
         // valid csr
-        cout << setw(16) << setfill('0') << hex << csrs[csr_num] << endl;
+        if (csr_num <= 0x003) sync_fflags();
+        cout << setw(16) << setfill('0') << hex << read_csr(csr_num) << endl;
+    }
+}
+
+// current value of the event source behind counter index (0 cycle, 1 time, 2 instret, 3-31 mhpmevent)
+// mhpmevent selects 1 loads, 2 stores, 3 taken branches, 4 traps, 5 L1I misses, 6 L1D misses,
+// 7 TLB misses or 8 page table walks
+uint64_t processor::counter_source(unsigned int index)
+{
+    switch(index)
+    {
+        case 0:
+            // cycle from the timing or cost model, one per tick without either
+            if (timing_thread != NULL) timing_thread->drain();
+            if (timing != NULL || cost_model != NULL) return get_cycle_count();
+            return ticks();
+        case 1:
+            return clint != NULL ? clint->getMtime(ticks()) : ticks();
+        case 2:
+            return ins_count;
+        default:
+            break;
+    }
+    switch(csrs[0x320 + index])
+    {
+        case 1: return loads;
+        case 2: return stores;
+        case 3: return branches_taken;
+        case 4: return traps;
+        case 5: return icache != NULL ? icache->getMisses() : 0;
+        case 6: return dcache != NULL ? dcache->getMisses() : 0;
+        case 7: return tlb_misses;
+        case 8: return page_walks;
+        default: return 0;
     }
 }
 
+// read a csr, computing the counters from their event sources
+uint64_t processor::read_csr(unsigned int csr_num)
+{
+    // counters advance every iteration, so a loop reading one is not a spin
+    if ((csr_num >= 0xc00 && csr_num <= 0xc1f) || (csr_num >= 0xb00 && csr_num <= 0xb1f)) spin_dirty = true;
+    if (csr_num >= 0xc00 && csr_num <= 0xc1f) return counter_source(csr_num - 0xc00) - counter_base[csr_num - 0xc00];
+    if (csr_num >= 0xb00 && csr_num <= 0xb1f) return counter_source(csr_num - 0xb00) - counter_base[csr_num - 0xb00];
+
+    // sstatus, sie and sip are views of the machine registers
+    if (csr_num == 0x100) return csrs[0x300] & 0x80000003000c6722;
+    if (csr_num == 0x104) return csrs[0x304] & csrs[0x303];
+    if (csr_num == 0x144) return csrs[0x344] & csrs[0x303];
+
+    // with 8-byte granularity pmpaddr bit 0 reads as zero unless the entry is napot
+    if (csr_num >= 0x3b0 && csr_num <= 0x3bf && (pmp_regions[csr_num - 0x3b0].cfg & 0x18) != 0x18) return csrs[csr_num] & ~0x1ULL;
+    return csrs[csr_num];
+}
+
+// return true for the vector csrs
+bool processor::is_vector_csr(unsigned int csr_num)
+{
+    return csr_num == 0x008 || (csr_num >= 0xc20 && csr_num <= 0xc22);
+}
+
+// write a csr from a csr instruction, which does not count itself in a minstret it writes,
+// so the next instruction reads the written value
+void processor::csr_ins_write(unsigned int csr_num, uint64_t new_value)
+{
+    set_csr(csr_num, new_value);
+    if (csr_num == 0xb02) counter_base[2]++;
+}
+
+// return true if the current instruction may access csr_num, writing if write is set
+bool processor::csr_accessible(unsigned int csr_num, bool write)
+{
+    if (csrs.find(csr_num) == csrs.end()) return false;
+
+    // csr_num[9:8] is the lowest privilege level allowed, csr_num[11:10] == 3 is read-only
+    if (((csr_num >> 8) & 0x3) > prv) return false;
+    if ((csr_num >> 10) == 0x3 && write) return false;
+
+    // floating point and vector csrs are unavailable while mstatus.fs or mstatus.vs is off
+    if (csr_num <= 0x003 && ((csrs[0x300] >> 13) & 0x3) == 0) return false;
+    if (is_vector_csr(csr_num) && ((csrs[0x300] >> 9) & 0x3) == 0) return false;
+
+    // user mode counters are enabled by mcounteren, and also by scounteren in user mode
+    if (csr_num >= 0xc00 && csr_num <= 0xc1f && prv < 3 && ((csrs[0x306] >> (csr_num - 0xc00)) & 0x1) == 0) return false;
+    if (csr_num >= 0xc00 && csr_num <= 0xc1f && prv == 0 && ((csrs[0x106] >> (csr_num - 0xc00)) & 0x1) == 0) return false;
+
+    // mstatus.tvm traps satp in supervisor mode
+    if (csr_num == 0x180 && prv == 1 && ((csrs[0x300] >> 20) & 0x1) == 1) return false;
+    return true;
+}
+
 // Set CSR to new value
 // Empty implementation for stage 1, required for stage 2
 void processor::set_csr(unsigned int csr_num, uint64_t new_value)
 {
+    spin_dirty = true;
+
     // invalid csr number
     if(csrs.find(csr_num) == csrs.end()) return;
 
-    // read-only csrs
-    if(csr_num == 0xf11 || csr_num == 0xf12 || csr_num == 0xf13 || csr_num == 0xf14)
+    // read-only csrs, csr_num[11:10] == 3
+    if((csr_num >> 10) == 0x3)
     {
         cout<<"Illegal write to read-only CSR"<<endl;
         return;
     }
+
+    // mcycle, minstret and mhpmcounter
+    if (csr_num >= 0xb00 && csr_num <= 0xb1f)
+    {
+        counter_base[csr_num - 0xb00] = counter_source(csr_num - 0xb00) - new_value;
+        return;
+    }
+
+    // pmpcfg and pmpaddr rebuild the regions
+    if (csr_num == 0x3a0 || csr_num == 0x3a2 || (csr_num >= 0x3b0 && csr_num <= 0x3bf))
+    {
+        set_pmp(csr_num, new_value);
+        return;
+    }
+
+    // mhpmevent: unknown events count nothing, the counter keeps its value across a change
+    if (csr_num >= 0x323 && csr_num <= 0x33f)
+    {
+        uint64_t value = read_csr(csr_num - 0x323 + 0xb03);
+        csrs[csr_num] = new_value <= 8 ? new_value : 0;
+        counter_base[csr_num - 0x323 + 3] = counter_source(csr_num - 0x323 + 3) - value;
+        return;
+    }
     
+    // supervisor views write through to the machine registers
+    if (csr_num == 0x100)
+    {
+        set_csr(0x300, (csrs[0x300] & ~0xc6722ULL) | (new_value & 0xc6722));
+        return;
+    }
+    if (csr_num == 0x104)
+    {
+        set_csr(0x304, (csrs[0x304] & ~csrs[0x303]) | (new_value & csrs[0x303]));
+        return;
+    }
+    if (csr_num == 0x144)
+    {
+        set_csr(0x344, (csrs[0x344] & ~(csrs[0x303] & 0x2)) | (new_value & csrs[0x303] & 0x2));
+        return;
+    }
+
     // writable csrs
     switch(csr_num)
     {
+        case 0x001:
+            // fflags: 5 bits, also the low bits of fcsr
+            csrs[0x300] |= 0x8000000000006000;
+            new_value &= 0x1f;
+            csrs[0x003] = (csrs[0x003] & ~0x1fULL) | new_value;
+            break;
+        case 0x002:
+            // frm: 3 bits, also bits 7:5 of fcsr
+            csrs[0x300] |= 0x8000000000006000;
+            new_value &= 0x7;
+            csrs[0x003] = (csrs[0x003] & 0x1f) | (new_value << 5);
+            break;
+        case 0x003:
+            // fcsr: frm and fflags
+            csrs[0x300] |= 0x8000000000006000;
+            new_value &= 0xff;
+            csrs[0x001] = new_value & 0x1f;
+            csrs[0x002] = new_value >> 5;
+            break;
+        case 0x008:
+            // vstart: element index below VLMAX
+            new_value &= vregisters.size() - 1;
+            csrs[0x300] |= 0x8000000000000600;
+            break;
+        case 0x105:
+            // stvec: as mtvec
+            if((new_value & 0x1) == 0)
+            {
+                // direct Mode
+                new_value &= 0xfffffffffffffffc;
+            }
+            else
+            {
+                // vectored Mode
+                new_value &= 0xffffffffffffff01;
+            }
+            break;
+        case 0x106:
+            // scounteren: one enable per user mode counter
+            new_value &= 0xffffffff;
+            break;
+        case 0x140:
+            // sscratch: all bits writable
+            break;
+        case 0x141:
+            // sepc: bit 0 fixed at 0
+            new_value &= 0xfffffffffffffffe;
+            break;
+        case 0x142:
+            // scause: only Interrupt bit and 4-bit cause
+            new_value &= 0x800000000000000f;
+            break;
+        case 0x143:
+            // stval: all bits writable
+            break;
+        case 0x180:
+            // satp: bare or Sv39, other modes leave it unchanged
+            if((new_value >> 60) != 0 && (new_value >> 60) != 8) return;
+            new_value &= 0xf0000fffffffffff;
+            paging = (new_value >> 60) == 8;
+            break;
         case 0x300:
-            // mstatus: only mie, mpie, mpp implemented
-            new_value &= 0x1888;
+            // mstatus: only sie, mie, spie, mpie, spp, vs, mpp, fs, mprv, sum, mxr, tvm, tw and tsr implemented,
+            // sd summarises a dirty fs or vs, mpp cannot hold the hypervisor mode
+            new_value &= Isa::mstatus_mask;
             new_value |= 0x200000000;
+            if (((new_value >> 11) & 0x3) == 0x2) new_value &= 0xffffffffffffe7ff;
+            if (((new_value >> 13) & 0x3) == 0x3 || ((new_value >> 9) & 0x3) == 0x3) new_value |= 0x8000000000000000;
             break;
         case 0x301:
-            // misa: all bits fixed
-            new_value = 0x8000000000100100;
+            // misa: all bits fixed, derived from the extensions built
+            new_value = Isa::misa;
+            break;
+        case 0x302:
+            // medeleg: all exceptions but ecall from machine mode can be delegated
+            new_value &= 0xb3ff;
+            break;
+        case 0x303:
+            // mideleg: supervisor interrupts
+            new_value &= 0x222;
             break;
         case 0x304:
-            // mie: only usie, msie, utie, mtie, ueie, meie implemented
-            new_value &= 0x999;
+            // mie: only usie, ssie, msie, utie, stie, mtie, ueie, seie, meie implemented
+            new_value &= 0xbbb;
+            break;
+        case 0x306:
+            // mcounteren: one enable per user mode counter
+            new_value &= 0xffffffff;
             break;
         case 0x305:
             // mtvec: bit 1 fixed at 0, if vectored, bits 7:2 also fixed at 0
@@ -269,8 +718,8 @@ void processor::set_csr(unsigned int csr_num, uint64_t new_value)
             // mscratch: all bits writable
             break;
         case 0x341:
-            // mepc: bit 1:0 fixed at 0
-            new_value &= 0xfffffffffffffffc;
+            // mepc: bit 0 fixed at 0
+            new_value &= 0xfffffffffffffffe;
             break;
         case 0x342:
             // mcause: only Interrupt bit and 4-bit cause
@@ -280,8 +729,8 @@ void processor::set_csr(unsigned int csr_num, uint64_t new_value)
             // mtval: all bits writable
             break;
         case 0x344:
-            // mip: only usip, msip, utip, mtip, ueip, meip implemented
-            new_value &= 0x999;
+            // mip: only usip, ssip, msip, utip, stip, mtip, ueip, seip, meip implemented
+            new_value &= 0xbbb;
             break;
         default:
             break;
@@ -296,9 +745,122 @@ uint64_t processor::get_instruction_count()
     return ins_count;
 }
 
+// returns the host seconds spent executing instructions
+double processor::get_host_seconds()
+{
+    return host_seconds;
+}
+
+// returns the ticks skipped while waiting in wfi
+uint64_t processor::get_idle_ticks()
+{
+    return idle_ticks;
+}
+
+// Skip spin loops that wait for an event
+void processor::set_skip_spin(bool enabled)
+{
+    skip_spin_enabled = enabled;
+}
+
+// Set the vector register length in bits, returning false if unsupported
+// a power of two from ELEN (64) up to 4096
+bool processor::set_vlen(unsigned int bits)
+{
+    if (bits < 64 || bits > 4096 || (bits & (bits - 1)) != 0) return false;
+    vlenb = bits / 8;
+    vregisters.assign(32 * vlenb, 0);
+    if (Isa::v) csrs[0xc22] = vlenb;
+    return true;
+}
+
+// returns the instructions skipped in spin loops
+uint64_t processor::get_spin_skipped()
+{
+    return spin_skipped;
+}
+
+// returns TLB lookups that hit
+uint64_t processor::get_tlb_hits()
+{
+    return tlb_hits;
+}
+
+// returns TLB lookups that missed
+uint64_t processor::get_tlb_misses()
+{
+    return tlb_misses;
+}
+
+// returns page table walks, on misses and on the first store to a clean page
+uint64_t processor::get_page_walks()
+{
+    return page_walks;
+}
+
+// Attach a timing model
+void processor::set_timing_model(TimingModel* timing)
+{
+    this->timing = timing;
+}
+
+// Attach instruction and data cache models
+void processor::set_caches(Cache* icache, Cache* dcache)
+{
+    this->icache = icache;
+    this->dcache = dcache;
+}
+
+// Attach a cache sweep
+void processor::set_cache_sweep(CacheSweep* sweep)
+{
+    this->sweep = sweep;
+}
+
+// Attach a branch prediction unit
+void processor::set_branch_unit(BranchUnit* branch_unit)
+{
+    this->branch_unit = branch_unit;
+}
+
+// Run the timing model and branch predictors on a separate thread
+void processor::set_timing_thread(TimingThread* timing_thread)
+{
+    this->timing_thread = timing_thread;
+}
+
+// Attach an analytical cost model
+void processor::set_cost_model(CostModel* cost_model)
+{
+    this->cost_model = cost_model;
+}
+
+// Attach a CLINT timer device
+void processor::set_clint(Clint* clint)
+{
+    this->clint = clint;
+    update_clint();
+}
+
+// Load an interrupt and event schedule, false on error
+bool processor::load_events(string file_name)
+{
+    return events->load(file_name);
+}
+
+// return instruction names indexed by code
+const vector<string>& processor::get_ins_names()
+{
+    return decoder->getInsNames();
+}
+
 // Used for Postgraduate assignment. Undergraduate assignment can return 0.
+// timing model cycles when enabled, otherwise the analytical estimate
 uint64_t processor::get_cycle_count()
 {
+    // skipped spin loop instructions are charged one cycle each
+    if (timing != NULL) return timing->getCycles() + idle_ticks + spin_skipped;
+    if (cost_model != NULL) return cost_model->getCycles() + idle_ticks + spin_skipped;
     return 0;
 }
 
@@ -308,7 +870,18 @@ void processor::executeIns()
     Ins insCode = decoder->getInsCode();
     uint64_t tmp = 0;
     uint64_t mask = 0;
+#if ISA_ZICSR
     unsigned int csr_num;
+#endif
+
+    // floating point and vector instructions, fflags is brought up to date before csr reads
+#if ISA_FD
+    if (insCode >= ins_flw && insCode <= ins_fmv_d_x) executeFloat();
+#endif
+#if ISA_V
+    if (insCode >= ins_vsetvli && insCode <= ins_vredmax_vs) executeVector();
+#endif
+    if (insCode >= ins_csrrw && insCode <= ins_csrrci && decoder->getImm() <= 0x003) sync_fflags();
 
     switch(insCode)
     {
@@ -319,67 +892,69 @@ void processor::executeIns()
             set_reg(decoder->getRd(),pc + sext_32_64(decoder->getImm() << 12));
             break;
         case ins_jal:
-            set_reg(decoder->getRd(),pc + 4);
-            pc += sext_32_64(sext_20_32(decoder->getImm()) << 1);
-            if(pc % 2 != 0) pc -= (pc % 2);
+            jump(pc + sext_32_64(sext_20_32(decoder->getImm()) << 1), decoder->getRd());
             return;
         case ins_jalr:
-            tmp = pc + 4;
-            pc = sext_32_64(registers[decoder->getRs1()] + sext_12_32(decoder->getImm()));
-            set_reg(decoder->getRd(),tmp);
-            if(pc % 2 != 0) pc -= (pc % 2);
+            // bit 0 of the target is cleared before the alignment check
+            jump((registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()))) & ~0x1ULL, decoder->getRd());
             return;
         case ins_beq:
             if(registers[decoder->getRs1()] == registers[decoder->getRs2()])
             {
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_bne:
             if(registers[decoder->getRs1()] != registers[decoder->getRs2()])
             {   
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_blt:
             if(signedComp(registers[decoder->getRs1()],registers[decoder->getRs2()]))
             {   
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_bge:
             if(!signedComp(registers[decoder->getRs1()],registers[decoder->getRs2()]))
             {   
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_bltu:
             if(registers[decoder->getRs1()] < registers[decoder->getRs2()])
             {   
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_bgeu:
             if(registers[decoder->getRs1()] >= registers[decoder->getRs2()])
             {   
-                pc += sext_32_64(sext_12_32(decoder->getImm()) << 1);
+                branches_taken++;
+                jump(pc + sext_32_64(sext_12_32(decoder->getImm()) << 1), 0);
                 return;
             }
             break;
         case ins_lb:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
-            set_reg(decoder->getRd(),sext_8_64(main_memory->read_doubleword(tmp) >> (tmp % 8 * 8)));
+            set_reg(decoder->getRd(),sext_8_64(load_doubleword(tmp) >> (tmp % 8 * 8)));
             break;
         case ins_lh:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 2 == 0)
             {
-                set_reg(decoder->getRd(),sext_16_64(main_memory->read_doubleword(tmp) >> (tmp % 8 * 8)));
+                set_reg(decoder->getRd(),sext_16_64(load_doubleword(tmp) >> (tmp % 8 * 8)));
             }
             else
             {
@@ -390,7 +965,7 @@ void processor::executeIns()
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 4 == 0)
             {
-                set_reg(decoder->getRd(),sext_32_64(main_memory->read_doubleword(tmp) >> (tmp % 8 * 8)));
+                set_reg(decoder->getRd(),sext_32_64(load_doubleword(tmp) >> (tmp % 8 * 8)));
             }
             else
             {
@@ -399,13 +974,13 @@ void processor::executeIns()
             break;
         case ins_lbu:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
-            set_reg(decoder->getRd(),main_memory->read_doubleword(tmp) >> (tmp % 8 * 8) & 0xff);
+            set_reg(decoder->getRd(),load_doubleword(tmp) >> (tmp % 8 * 8) & 0xff);
             break;
         case ins_lhu:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 2 == 0)
             {
-                set_reg(decoder->getRd(),main_memory->read_doubleword(tmp) >> (tmp % 8 * 8) & 0xffff);
+                set_reg(decoder->getRd(),load_doubleword(tmp) >> (tmp % 8 * 8) & 0xffff);
             }
             else
             {
@@ -416,7 +991,7 @@ void processor::executeIns()
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             mask = 0xff;
             mask <<= (tmp % 8 * 8);
-            main_memory->write_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
+            store_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
             break;
         case ins_sh:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
@@ -424,7 +999,7 @@ void processor::executeIns()
             {
                 mask = 0xffff;
                 mask <<= (tmp % 8 * 8);
-                main_memory->write_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
+                store_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
             }
             else
             {
@@ -437,7 +1012,7 @@ void processor::executeIns()
             {
                 mask = 0xffffffff;
                 mask <<= (tmp % 8 * 8);
-                main_memory->write_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
+                store_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
             }
             else
             {
@@ -554,16 +1129,62 @@ void processor::executeIns()
             // no action
             break;
         case ins_ecall:
+            if(halt_on_ecall && registers[17] == halt_ecall_a7)
+            {
+                // halt without taking the trap
+                cout << "ecall halt reached at " << setw(16) << setfill('0') << hex << pc << endl;
+                halted = true;
+                ins_count --;
+                return;
+            }
             if(prv == 0)
             {
                 except(8);
             }
+            else if(prv == 1)
+            {
+                except(9);
+            }
             else if(prv == 3)
             {
                 except(11);
             }
             break;
+        case ins_wfi:
+            if(verbose) cout << "wfi" << endl;
+            if(prv < 3 && ((csrs[0x300] >> 21) & 0x1) == 1)
+            {
+                // mstatus.tw traps wfi below machine mode
+                except(2);
+            }
+            else if(events->nextDeadline() == UINT64_MAX && (csrs[0x344] & csrs[0x304]) == 0)
+            {
+                // nothing can wake the hart
+                cout << "wfi halt reached at " << setw(16) << setfill('0') << hex << pc << endl;
+                halted = true;
+                ins_count --;
+                return;
+            }
+            else
+            {
+                wait_for_interrupt();
+            }
+            break;
         case ins_ebreak:
+            if(halt_on_ebreak)
+            {
+                // halt without taking the trap
+                cout << "ebreak halt reached at " << setw(16) << setfill('0') << hex << pc << endl;
+                halted = true;
+                ins_count --;
+                return;
+            }
+            if(prv != 3 && ((csrs[0x302] >> 3) & 0x1) == 1)
+            {
+                // delegated in medeleg
+                except(3);
+                break;
+            }
             if(verbose)
             {
                 cout << "ebreak" << endl;
@@ -572,6 +1193,8 @@ void processor::executeIns()
                     << ", val = " << setw(16) << setfill('0') << hex << decoder->getIns() << endl;
             }
 
+            trapped = true;
+
             // store current pc into mepc
             set_csr(0x341,pc);
 
@@ -594,11 +1217,11 @@ void processor::executeIns()
                 // mpp = 3
                 csrs[0x300] |= 0x1800;
             }
-            else if(prv == 0)
+            else
             {
-                // user
-                // mpp = 0
-                csrs[0x300] &= 0xffffffffffffe7ff;
+                // user or supervisor
+                // mpp = 0 or 1
+                csrs[0x300] = (csrs[0x300] & 0xffffffffffffe7ff) | ((uint64_t)prv << 11);
             }
 
             // set mpie
@@ -626,13 +1249,13 @@ void processor::executeIns()
             ins_count --;
 
             // decrement pc
-            pc -= 4;
+            pc -= decoder->getInsLength();
             break;
         case ins_lwu:
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 4 == 0)
             {
-                set_reg(decoder->getRd(),main_memory->read_doubleword(tmp) >> (tmp % 8 * 8) & 0xffffffff);
+                set_reg(decoder->getRd(),load_doubleword(tmp) >> (tmp % 8 * 8) & 0xffffffff);
             }
             else
             {
@@ -643,7 +1266,7 @@ void processor::executeIns()
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 8 == 0)
             {
-                set_reg(decoder->getRd(),main_memory->read_doubleword(tmp));
+                set_reg(decoder->getRd(),load_doubleword(tmp));
             }
             else
             {
@@ -654,7 +1277,7 @@ void processor::executeIns()
             tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
             if (tmp % 8 == 0)
             {
-                main_memory->write_doubleword(tmp,registers[decoder->getRs2()],0xffffffffffffffff);
+                store_doubleword(tmp,registers[decoder->getRs2()],0xffffffffffffffff);
             }
             else
             {
@@ -708,168 +1331,1616 @@ void processor::executeIns()
             }
             set_reg(decoder->getRd(),(sext_32_64(registers[decoder->getRs1()]) >> mask) + tmp);
             break;
-        case ins_mret:
-            if(verbose) cout << "mret" << endl;
-            if(prv == 0)
+#if ISA_M
+        case ins_mul:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] * registers[decoder->getRs2()]);
+            break;
+        case ins_mulh:
+            set_reg(decoder->getRd(),(uint64_t)(((int128_t)(int64_t)registers[decoder->getRs1()] *
+                (int128_t)(int64_t)registers[decoder->getRs2()]) >> 64));
+            break;
+        case ins_mulhsu:
+            set_reg(decoder->getRd(),(uint64_t)(((int128_t)(int64_t)registers[decoder->getRs1()] *
+                (int128_t)registers[decoder->getRs2()]) >> 64));
+            break;
+        case ins_mulhu:
+            set_reg(decoder->getRd(),(uint64_t)(((uint128_t)registers[decoder->getRs1()] *
+                (uint128_t)registers[decoder->getRs2()]) >> 64));
+            break;
+        case ins_div:
+            // divide by zero gives -1, overflow gives the dividend
+            if (registers[decoder->getRs2()] == 0)
+                tmp = 0xffffffffffffffff;
+            else if (registers[decoder->getRs1()] == 0x8000000000000000 && registers[decoder->getRs2()] == 0xffffffffffffffff)
+                tmp = registers[decoder->getRs1()];
+            else
+                tmp = (int64_t)registers[decoder->getRs1()] / (int64_t)registers[decoder->getRs2()];
+            set_reg(decoder->getRd(),tmp);
+            break;
+        case ins_divu:
+            if (registers[decoder->getRs2()] == 0)
+                tmp = 0xffffffffffffffff;
+            else
+                tmp = registers[decoder->getRs1()] / registers[decoder->getRs2()];
+            set_reg(decoder->getRd(),tmp);
+            break;
+        case ins_rem:
+            // remainder by zero gives the dividend, overflow gives 0
+            if (registers[decoder->getRs2()] == 0)
+                tmp = registers[decoder->getRs1()];
+            else if (registers[decoder->getRs1()] == 0x8000000000000000 && registers[decoder->getRs2()] == 0xffffffffffffffff)
+                tmp = 0;
+            else
+                tmp = (int64_t)registers[decoder->getRs1()] % (int64_t)registers[decoder->getRs2()];
+            set_reg(decoder->getRd(),tmp);
+            break;
+        case ins_remu:
+            if (registers[decoder->getRs2()] == 0)
+                tmp = registers[decoder->getRs1()];
+            else
+                tmp = registers[decoder->getRs1()] % registers[decoder->getRs2()];
+            set_reg(decoder->getRd(),tmp);
+            break;
+        case ins_mulw:
+            set_reg(decoder->getRd(),sext_32_64((registers[decoder->getRs1()] * registers[decoder->getRs2()]) & 0xffffffff));
+            break;
+        case ins_divw:
             {
-                except(2);
+                int32_t a = (int32_t)registers[decoder->getRs1()];
+                int32_t b = (int32_t)registers[decoder->getRs2()];
+                if (b == 0) tmp = 0xffffffffffffffff;
+                else if (a == INT32_MIN && b == -1) tmp = sext_32_64((uint32_t)a);
+                else tmp = sext_32_64((uint32_t)(a / b));
+                set_reg(decoder->getRd(),tmp);
             }
-            else
+            break;
+        case ins_divuw:
             {
-                // set pc to mepc
-                pc = csrs[0x341] - 4;
-
-                // set priviledge by mpp
-                if(((csrs[0x300] >> 11) & 0x3) == 3)
-                {
-                    prv = 3;
-                }
-                else
-                {
-                    prv = 0;
-                }
+                uint32_t a = (uint32_t)registers[decoder->getRs1()];
+                uint32_t b = (uint32_t)registers[decoder->getRs2()];
+                tmp = b == 0 ? 0xffffffffffffffff : sext_32_64(a / b);
+                set_reg(decoder->getRd(),tmp);
+            }
+            break;
+        case ins_remw:
+            {
+                int32_t a = (int32_t)registers[decoder->getRs1()];
+                int32_t b = (int32_t)registers[decoder->getRs2()];
+                if (b == 0) tmp = sext_32_64((uint32_t)a);
+                else if (a == INT32_MIN && b == -1) tmp = 0;
+                else tmp = sext_32_64((uint32_t)(a % b));
+                set_reg(decoder->getRd(),tmp);
+            }
+            break;
+        case ins_remuw:
+            {
+                uint32_t a = (uint32_t)registers[decoder->getRs1()];
+                uint32_t b = (uint32_t)registers[decoder->getRs2()];
+                tmp = b == 0 ? sext_32_64(a) : sext_32_64(a % b);
+                set_reg(decoder->getRd(),tmp);
+            }
+            break;
+#endif
+#if ISA_A
+        case ins_lr_w:
+        case ins_lr_d:
+            tmp = registers[decoder->getRs1()];
+            if (tmp % (insCode == ins_lr_w ? 4 : 8) == 0)
+            {
+                uint64_t data = load_doubleword(tmp) >> (tmp % 8 * 8);
+                set_reg(decoder->getRd(),insCode == ins_lr_w ? sext_32_64(data & 0xffffffff) : data);
+                reserved = true;
+                reservation = tmp - (tmp % 8);
+            }
+            else
+            {
+                except(4);
+            }
+            break;
+        case ins_sc_w:
+        case ins_sc_d:
+            tmp = registers[decoder->getRs1()];
+            if (tmp % (insCode == ins_sc_w ? 4 : 8) != 0)
+            {
+                except(6);
+            }
+            else if (reserved && reservation == tmp - (tmp % 8))
+            {
+                mask = insCode == ins_sc_w ? 0xffffffff : 0xffffffffffffffff;
+                mask <<= (tmp % 8 * 8);
+                store_doubleword(tmp,registers[decoder->getRs2()] << (tmp % 8 * 8),mask);
+                set_reg(decoder->getRd(),0);
+            }
+            else
+            {
+                set_reg(decoder->getRd(),1);
+            }
+            reserved = false;
+            break;
+        case ins_amoswap_w: case ins_amoadd_w: case ins_amoxor_w: case ins_amoand_w: case ins_amoor_w:
+        case ins_amomin_w: case ins_amomax_w: case ins_amominu_w: case ins_amomaxu_w:
+        case ins_amoswap_d: case ins_amoadd_d: case ins_amoxor_d: case ins_amoand_d: case ins_amoor_d:
+        case ins_amomin_d: case ins_amomax_d: case ins_amominu_d: case ins_amomaxu_d:
+            {
+                // a single hart performs the read-modify-write as a plain load and store
+                bool word = insCode <= ins_amomaxu_w;
+                Ins op = word ? insCode : (Ins)(insCode - ins_lr_d + ins_lr_w);
+                tmp = registers[decoder->getRs1()];
+                if (tmp % (word ? 4 : 8) != 0)
+                {
+                    except(6);
+                    break;
+                }
+                uint64_t old = load_doubleword(tmp) >> (tmp % 8 * 8);
+                uint64_t src = registers[decoder->getRs2()];
+                unsigned int penalty = mem_penalty;
+                if (word)
+                {
+                    // sign extended words keep both signed and unsigned order
+                    old = sext_32_64(old & 0xffffffff);
+                    src = sext_32_64(src & 0xffffffff);
+                }
+                uint64_t result;
+                switch(op)
+                {
+                    case ins_amoswap_w: result = src; break;
+                    case ins_amoadd_w: result = old + src; break;
+                    case ins_amoxor_w: result = old ^ src; break;
+                    case ins_amoand_w: result = old & src; break;
+                    case ins_amoor_w: result = old | src; break;
+                    case ins_amomin_w: result = (int64_t)old < (int64_t)src ? old : src; break;
+                    case ins_amomax_w: result = (int64_t)old > (int64_t)src ? old : src; break;
+                    case ins_amominu_w: result = old < src ? old : src; break;
+                    default: result = old > src ? old : src; break;
+                }
+                mask = word ? 0xffffffff : 0xffffffffffffffff;
+                mask <<= (tmp % 8 * 8);
+                store_doubleword(tmp,result << (tmp % 8 * 8),mask);
+                mem_penalty += penalty;
+                set_reg(decoder->getRd(),old);
+            }
+            break;
+#endif
+#if ISA_B
+        case ins_sh1add:
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] << 1) + registers[decoder->getRs2()]);
+            break;
+        case ins_sh2add:
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] << 2) + registers[decoder->getRs2()]);
+            break;
+        case ins_sh3add:
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] << 3) + registers[decoder->getRs2()]);
+            break;
+        case ins_add_uw:
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] & 0xffffffff) + registers[decoder->getRs2()]);
+            break;
+        case ins_sh1add_uw:
+            set_reg(decoder->getRd(),((registers[decoder->getRs1()] & 0xffffffff) << 1) + registers[decoder->getRs2()]);
+            break;
+        case ins_sh2add_uw:
+            set_reg(decoder->getRd(),((registers[decoder->getRs1()] & 0xffffffff) << 2) + registers[decoder->getRs2()]);
+            break;
+        case ins_sh3add_uw:
+            set_reg(decoder->getRd(),((registers[decoder->getRs1()] & 0xffffffff) << 3) + registers[decoder->getRs2()]);
+            break;
+        case ins_slli_uw:
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] & 0xffffffff) << (((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2()));
+            break;
+        case ins_andn:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] & ~registers[decoder->getRs2()]);
+            break;
+        case ins_orn:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] | ~registers[decoder->getRs2()]);
+            break;
+        case ins_xnor:
+            set_reg(decoder->getRd(),~(registers[decoder->getRs1()] ^ registers[decoder->getRs2()]));
+            break;
+        case ins_clz:
+            tmp = registers[decoder->getRs1()];
+            set_reg(decoder->getRd(),tmp == 0 ? 64 : __builtin_clzll(tmp));
+            break;
+        case ins_ctz:
+            tmp = registers[decoder->getRs1()];
+            set_reg(decoder->getRd(),tmp == 0 ? 64 : __builtin_ctzll(tmp));
+            break;
+        case ins_cpop:
+            set_reg(decoder->getRd(),__builtin_popcountll(registers[decoder->getRs1()]));
+            break;
+        case ins_clzw:
+            tmp = registers[decoder->getRs1()] & 0xffffffff;
+            set_reg(decoder->getRd(),tmp == 0 ? 32 : __builtin_clz((uint32_t)tmp));
+            break;
+        case ins_ctzw:
+            tmp = registers[decoder->getRs1()] & 0xffffffff;
+            set_reg(decoder->getRd(),tmp == 0 ? 32 : __builtin_ctz((uint32_t)tmp));
+            break;
+        case ins_cpopw:
+            set_reg(decoder->getRd(),__builtin_popcount((uint32_t)registers[decoder->getRs1()]));
+            break;
+        case ins_min:
+            set_reg(decoder->getRd(),signedComp(registers[decoder->getRs1()],registers[decoder->getRs2()]) ? registers[decoder->getRs1()] : registers[decoder->getRs2()]);
+            break;
+        case ins_minu:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] < registers[decoder->getRs2()] ? registers[decoder->getRs1()] : registers[decoder->getRs2()]);
+            break;
+        case ins_max:
+            set_reg(decoder->getRd(),signedComp(registers[decoder->getRs1()],registers[decoder->getRs2()]) ? registers[decoder->getRs2()] : registers[decoder->getRs1()]);
+            break;
+        case ins_maxu:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] > registers[decoder->getRs2()] ? registers[decoder->getRs1()] : registers[decoder->getRs2()]);
+            break;
+        case ins_sext_b:
+            set_reg(decoder->getRd(),sext_8_64(registers[decoder->getRs1()] & 0xff));
+            break;
+        case ins_sext_h:
+            set_reg(decoder->getRd(),sext_16_64(registers[decoder->getRs1()] & 0xffff));
+            break;
+        case ins_zext_h:
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] & 0xffff);
+            break;
+        case ins_rol:
+            tmp = registers[decoder->getRs2()] & 0x3f;
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] << tmp) | (registers[decoder->getRs1()] >> ((64 - tmp) & 0x3f)));
+            break;
+        case ins_ror:
+        case ins_rori:
+            tmp = insCode == ins_ror ? registers[decoder->getRs2()] & 0x3f : ((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2();
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] >> tmp) | (registers[decoder->getRs1()] << ((64 - tmp) & 0x3f)));
+            break;
+        case ins_rolw:
+            {
+                uint32_t val = (uint32_t)registers[decoder->getRs1()];
+                tmp = registers[decoder->getRs2()] & 0x1f;
+                set_reg(decoder->getRd(),sext_32_64((uint32_t)((val << tmp) | (val >> ((32 - tmp) & 0x1f)))));
+            }
+            break;
+        case ins_rorw:
+        case ins_roriw:
+            {
+                uint32_t val = (uint32_t)registers[decoder->getRs1()];
+                tmp = insCode == ins_rorw ? registers[decoder->getRs2()] & 0x1f : decoder->getRs2();
+                set_reg(decoder->getRd(),sext_32_64((uint32_t)((val >> tmp) | (val << ((32 - tmp) & 0x1f)))));
+            }
+            break;
+        case ins_orc_b:
+            {
+                uint64_t val = registers[decoder->getRs1()];
+                uint64_t result = 0;
+                for (int byte = 0; byte < 8; byte++)
+                {
+                    if ((val >> (byte * 8)) & 0xff) result |= 0xffULL << (byte * 8);
+                }
+                set_reg(decoder->getRd(),result);
+            }
+            break;
+        case ins_rev8:
+            set_reg(decoder->getRd(),__builtin_bswap64(registers[decoder->getRs1()]));
+            break;
+        case ins_bclr:
+        case ins_bclri:
+            tmp = insCode == ins_bclr ? registers[decoder->getRs2()] & 0x3f : ((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2();
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] & ~(1ULL << tmp));
+            break;
+        case ins_bext:
+        case ins_bexti:
+            tmp = insCode == ins_bext ? registers[decoder->getRs2()] & 0x3f : ((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2();
+            set_reg(decoder->getRd(),(registers[decoder->getRs1()] >> tmp) & 0x1);
+            break;
+        case ins_binv:
+        case ins_binvi:
+            tmp = insCode == ins_binv ? registers[decoder->getRs2()] & 0x3f : ((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2();
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] ^ (1ULL << tmp));
+            break;
+        case ins_bset:
+        case ins_bseti:
+            tmp = insCode == ins_bset ? registers[decoder->getRs2()] & 0x3f : ((decoder->getFunct7() & 0x1) << 5) + decoder->getRs2();
+            set_reg(decoder->getRd(),registers[decoder->getRs1()] | (1ULL << tmp));
+            break;
+#endif
+        case ins_mret:
+            if(verbose) cout << "mret" << endl;
+            if(prv != 3)
+            {
+                except(2);
+            }
+            else
+            {
+                // set pc to mepc
+                pc = csrs[0x341] - decoder->getInsLength();
+
+                // set priviledge by mpp, leaving machine mode clears mprv
+                prv = (csrs[0x300] >> 11) & 0x3;
+                if(prv != 3) csrs[0x300] &= 0xfffffffffffdffff;
+
+                // set mpp = 0
+                csrs[0x300] &= 0xffffffffffffe7ff;
+
+                // set mie to mpie
+                if(((csrs[0x300] >> 7) & 0x1) == 1)
+                {
+                    // mie = 1
+                    csrs[0x300] |= 0x8;
+                }
+                else
+                {
+                    // mie = 0
+                    csrs[0x300] &= 0xfffffffffffffff7;
+                }
+
+                // set mpie = 0
+                csrs[0x300] |= 0x80;
+            }
+            break;
+        case ins_sret:
+            if(verbose) cout << "sret" << endl;
+            if(prv == 0 || (prv == 1 && ((csrs[0x300] >> 22) & 0x1) == 1))
+            {
+                // user mode, or supervisor mode with mstatus.tsr
+                except(2);
+            }
+            else
+            {
+                // set pc to sepc
+                pc = csrs[0x141] - decoder->getInsLength();
+
+                // set priviledge by spp, clear mprv
+                prv = (csrs[0x300] >> 8) & 0x1;
+                csrs[0x300] &= 0xfffffffffffdffff;
+
+                // set sie to spie, spie = 1, spp = 0
+                csrs[0x300] = (csrs[0x300] & 0xfffffffffffffefd) | ((csrs[0x300] >> 4) & 0x2) | 0x20;
+            }
+            break;
+        case ins_sfence_vma:
+            if(prv == 0 || (prv == 1 && ((csrs[0x300] >> 20) & 0x1) == 1))
+            {
+                // user mode, or supervisor mode with mstatus.tvm
+                except(2);
+            }
+            else
+            {
+                sfence_vma(decoder->getRs1(),decoder->getRs2());
+            }
+            break;
+#if ISA_ZICSR
+        case ins_csrrw:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = registers[decoder->getRs1()];
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                csr_ins_write(csr_num,tmp);
+            }
+            break;
+        case ins_csrrs:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = read_csr(csr_num) | registers[decoder->getRs1()];
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                if(decoder->getRs1() != 0) csr_ins_write(csr_num,tmp);
+            }
+            break;
+        case ins_csrrc:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = read_csr(csr_num) & (~registers[decoder->getRs1()]);
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                if(decoder->getRs1() != 0) csr_ins_write(csr_num,tmp);
+            }
+            break;
+        case ins_csrrwi:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = decoder->getRs1();
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                csr_ins_write(csr_num,tmp);
+            }
+            break;
+        case ins_csrrsi:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = read_csr(csr_num) | decoder->getRs1();
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                if(decoder->getRs1() != 0) csr_ins_write(csr_num,tmp);
+            }
+            break;
+        case ins_csrrci:
+            csr_num = decoder->getImm();
+            if(!csr_accessible(csr_num, decoder->getRs1() != 0))
+            {
+                except(2);
+            }
+            else
+            {
+                tmp = read_csr(csr_num) & (~decoder->getRs1());
+                if(csr_num == 0x344) tmp &= 0x333;
+
+                set_reg(decoder->getRd(),read_csr(csr_num));
+                if(decoder->getRs1() != 0) csr_ins_write(csr_num,tmp);
+            }
+            break;
+#endif
+        case ins_default:
+            // undecodable, including the encodings of extensions left out of the build
+            except(2);
+            break;
+        default:
+            break;
+    }
+    
+    // increment program counter
+    pc += decoder->getInsLength();
+}
+
+// wait for an interrupt, skipping idle time to the next event
+// wfi resumes on any enabled pending interrupt, whether or not mstatus.mie allows it to be taken
+void processor::wait_for_interrupt()
+{
+    if ((csrs[0x344] & csrs[0x304]) != 0) return;
+
+    // instret stops while idle, mtime and cycle advance
+    uint64_t deadline = events->nextDeadline();
+    if (deadline > ticks()) idle_ticks += deadline - ticks();
+}
+
+// at a backward transfer from branch_pc, skip whole iterations of an unchanging loop
+// with no stores, csr writes or traps and identical registers at the loop head, every further
+// iteration is the same until an event changes memory or raises an interrupt
+uint64_t processor::skip_spin(uint64_t branch_pc, uint64_t budget)
+{
+    uint64_t length = ins_count - spin_start;
+    bool same = branch_pc == spin_branch && pc == spin_target && !spin_dirty && length <= 16 &&
+                memcmp(registers, spin_registers, sizeof(registers)) == 0;
+
+    // this transfer starts the next iteration
+    spin_branch = branch_pc;
+    spin_target = pc;
+    spin_start = ins_count;
+    spin_dirty = false;
+    if (!same)
+    {
+        memcpy(spin_registers, registers, sizeof(registers));
+        return 0;
+    }
+
+    // whole iterations that end before the next event
+    uint64_t deadline = events->nextDeadline();
+    if (deadline == UINT64_MAX || deadline <= ticks()) return 0;
+    uint64_t skipped = min(deadline - ticks(), budget) / length * length;
+    ins_count += skipped;
+    spin_skipped += skipped;
+    spin_start = ins_count;
+    return skipped;
+}
+
+// current time for the cache models, instructions when the timing model is not available inline
+uint64_t processor::cache_time()
+{
+    if (timing != NULL && timing_thread == NULL) return timing->getCycles();
+    return ins_count;
+}
+
+// update mip from the CLINT and schedule its next expiry
+void processor::update_clint()
+{
+    csrs[0x344] &= ~(uint64_t)0x88;
+    if (clint->timerPending(ticks())) csrs[0x344] |= 0x80;
+    if (clint->softwarePending()) csrs[0x344] |= 0x8;
+
+    // replace any earlier expiry event
+    clint_generation++;
+    uint64_t expiry = clint->nextExpiry(ticks());
+    if (expiry != UINT64_MAX)
+    {
+        EventQueue::Event event = {expiry, EventQueue::event_clint, clint_generation, 0};
+        events->schedule(event);
+    }
+}
+
+// handle events due at the current tick
+void processor::service_events()
+{
+    EventQueue::Event event;
+    while (events->pop(ticks(), event))
+    {
+        switch (event.type)
+        {
+            case EventQueue::event_clint:
+                if (event.arg0 == clint_generation) update_clint();
+                break;
+            case EventQueue::event_mip_set:
+                csrs[0x344] |= 1ULL << event.arg0;
+                break;
+            case EventQueue::event_mip_clear:
+                csrs[0x344] &= ~(1ULL << event.arg0);
+                break;
+            case EventQueue::event_csr:
+                set_csr(event.arg0,event.arg1);
+                break;
+            case EventQueue::event_mem:
+                main_memory->write_doubleword(event.arg0,event.arg1,0xffffffffffffffff);
+                break;
+        }
+    }
+}
+
+// translate a virtual address for a fetch (0), load (1) or store (2), raising a page fault on failure
+// called only while paging, machine mode uses physical addresses, loads and stores use mpp when mstatus.mprv is set
+bool processor::translate(uint64_t vaddr, int access, uint64_t& paddr)
+{
+    unsigned int eff_prv = prv;
+    if (access != 0 && prv == 3 && ((csrs[0x300] >> 17) & 0x1) == 1) eff_prv = (csrs[0x300] >> 11) & 0x3;
+    if (eff_prv == 3)
+    {
+        paddr = vaddr;
+        return true;
+    }
+
+    // bits 63:39 must match bit 38
+    uint64_t vpn = (vaddr >> 12) & 0x7ffffff;
+    uint16_t asid = (csrs[0x180] >> 44) & 0xffff;
+    bool canonical = ((int64_t)vaddr >> 38) == 0 || ((int64_t)vaddr >> 38) == -1;
+
+    // the index folds in all three vpn levels so aligned regions do not collide,
+    // a hit needs no walk unless it is the first store to a clean page
+    TlbEntry& entry = tlb[eff_prv][(vpn ^ (vpn >> 9) ^ (vpn >> 18)) & ((1 << tlb_bits) - 1)];
+    bool hit = canonical && entry.valid && entry.vpn == vpn && (entry.asid == asid || (entry.pte & 0x20) != 0);
+    int page_fault = access == 0 ? 12 : (access == 1 ? 13 : 15);
+    int fault = 0;
+    if (hit && (access != 2 || (entry.pte & 0x80) != 0))
+    {
+        tlb_hits++;
+        if (!pte_permits(entry.pte, access, eff_prv)) fault = page_fault;
+    }
+    else
+    {
+        if (hit) tlb_hits++;
+        else tlb_misses++;
+        fault = canonical ? page_walk(vaddr, access, eff_prv, entry) : page_fault;
+    }
+
+    if (fault != 0)
+    {
+        except(fault, vaddr);
+        access_fault = true;
+        return false;
+    }
+    paddr = (entry.ppn << 12) | (vaddr & 0xfff);
+    return true;
+}
+
+// walk the Sv39 page table for vaddr and refill entry, returning 0 or the cause of a page or access fault
+// accessed and dirty bits are set by the walk rather than faulting, pte accesses are checked by pmp
+// as supervisor accesses and fault as the access that caused the walk
+int processor::page_walk(uint64_t vaddr, int access, unsigned int eff_prv, TlbEntry& entry)
+{
+    uint64_t vpn = (vaddr >> 12) & 0x7ffffff;
+    uint64_t table = (csrs[0x180] & 0xfffffffffff) << 12;
+    int page_fault = access == 0 ? 12 : (access == 1 ? 13 : 15);
+    int access_denied = access == 0 ? 1 : (access == 1 ? 5 : 7);
+    page_walks++;
+
+    for (int level = 2; level >= 0; level--)
+    {
+        uint64_t pte_address = table + ((vpn >> (9 * level)) & 0x1ff) * 8;
+        if (pmp_active && !pmp_allows(pte_address, 1, 1)) return access_denied;
+        uint64_t pte = main_memory->read_doubleword(pte_address);
+
+        // invalid, writable without readable, or reserved bits set
+        if ((pte & 0x1) == 0 || (pte & 0x6) == 0x4 || (pte >> 54) != 0) return page_fault;
+
+        // neither readable nor executable points to the next level, with a, d and u reserved
+        if ((pte & 0xa) == 0)
+        {
+            if ((pte & 0xd0) != 0) return page_fault;
+            table = ((pte >> 10) & 0xfffffffffff) << 12;
+            continue;
+        }
+
+        // leaf, superpages must be aligned to their size
+        uint64_t ppn = (pte >> 10) & 0xfffffffffff;
+        uint64_t offset_mask = (1ULL << (9 * level)) - 1;
+        if ((ppn & offset_mask) != 0 || !pte_permits(pte, access, eff_prv)) return page_fault;
+
+        uint64_t updated = pte | 0x40 | (access == 2 ? 0x80 : 0);
+        if (updated != pte)
+        {
+            if (pmp_active && !pmp_allows(pte_address, 2, 1)) return access_denied;
+            main_memory->write_doubleword(pte_address, updated, 0xffffffffffffffff);
+            spin_dirty = true;
+        }
+
+        entry.vpn = vpn;
+        entry.ppn = ppn | (vpn & offset_mask);
+        entry.asid = (csrs[0x180] >> 44) & 0xffff;
+        entry.pte = updated & 0xff;
+        entry.level = level;
+        entry.valid = true;
+        return 0;
+    }
+    return page_fault;
+}
+
+// return true if a leaf pte allows the access at privilege eff_prv
+// supervisor mode never executes user pages and reads or writes them only with mstatus.sum,
+// mstatus.mxr makes executable pages readable
+bool processor::pte_permits(uint64_t pte, int access, unsigned int eff_prv)
+{
+    bool user_page = (pte & 0x10) != 0;
+    if (eff_prv == 0 && !user_page) return false;
+    if (eff_prv == 1 && user_page && (access == 0 || ((csrs[0x300] >> 18) & 0x1) == 0)) return false;
+
+    if (access == 0) return (pte & 0x8) != 0;
+    if (access == 1) return (pte & 0x2) != 0 || (((csrs[0x300] >> 19) & 0x1) == 1 && (pte & 0x8) != 0);
+    return (pte & 0x4) != 0;
+}
+
+// invalidate TLB entries for a virtual address and address space, all when the register is x0
+// global mappings are kept when flushing a single address space, and an address flushes
+// every cached slice of a superpage containing it
+void processor::sfence_vma(unsigned int rs1, unsigned int rs2)
+{
+    uint64_t vpn = (registers[rs1] >> 12) & 0x7ffffff;
+    uint16_t asid = registers[rs2] & 0xffff;
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        for (unsigned int i = 0; i < (1 << tlb_bits); i++)
+        {
+            TlbEntry& entry = tlb[mode][i];
+            bool covered = (entry.vpn >> (9 * entry.level)) == (vpn >> (9 * entry.level));
+            if ((rs1 == 0 || covered) && (rs2 == 0 || (entry.asid == asid && (entry.pte & 0x20) == 0)))
+            {
+                entry.valid = false;
+            }
+        }
+    }
+}
+
+// check a fetch (0), load (1) or store (2) at physical address paddr against pmp, raising an access fault on failure
+// loads and stores in machine mode are checked at mpp when mstatus.mprv is set
+bool processor::pmp_check(uint64_t vaddr, uint64_t paddr, int access)
+{
+    unsigned int eff_prv = prv;
+    if (access != 0 && prv == 3 && ((csrs[0x300] >> 17) & 0x1) == 1) eff_prv = (csrs[0x300] >> 11) & 0x3;
+    if (pmp_allows(paddr, access, eff_prv)) return true;
+
+    except(access == 0 ? 1 : (access == 1 ? 5 : 7), vaddr);
+    access_fault = true;
+    return false;
+}
+
+// return true if pmp allows the access to paddr at privilege eff_prv
+// the decision for the whole page is cached, only a page straddling a region boundary
+// is decided per doubleword, which the 8-byte granularity makes exact
+bool processor::pmp_allows(uint64_t paddr, int access, unsigned int eff_prv)
+{
+    if (eff_prv == 3 && !pmp_locked) return true;
+
+    uint64_t page = paddr >> 12;
+    PmpPage& entry = pmp_cache[page & ((1 << pmp_cache_bits) - 1)];
+    if (!entry.valid || entry.page != page)
+    {
+        entry.page = page;
+        entry.perm = pmp_permissions(page << 12, 4096);
+        entry.valid = true;
+    }
+    uint8_t perm = entry.perm;
+    if ((perm & 0x40) != 0) perm = pmp_permissions(paddr & ~0x7ULL, 8);
+
+    uint8_t needed = access == 0 ? 0x4 : (access == 1 ? 0x1 : 0x2);
+    return ((perm >> (eff_prv == 3 ? 3 : 0)) & needed) != 0;
+}
+
+// return the permission bits of the first entry matching any of the size bytes at base
+// an entry covering only part of them sets bit 6, no match allows only machine mode
+uint8_t processor::pmp_permissions(uint64_t base, uint64_t size)
+{
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        PmpRegion& region = pmp_regions[i];
+        if (region.high <= base || region.low >= base + size) continue;
+        if (region.low > base || region.high < base + size) return 0x40;
+
+        // unlocked entries do not apply to machine mode
+        uint8_t rwx = region.cfg & 0x7;
+        return rwx | (((region.cfg & 0x80) != 0 ? rwx : 0x7) << 3);
+    }
+    return 0x38;
+}
+
+// write a pmpcfg or pmpaddr register and rebuild the regions
+// locked entries ignore writes, as does the pmpaddr below a locked tor entry,
+// na4 is not selectable with 8-byte granularity and w without r is reserved
+void processor::set_pmp(unsigned int csr_num, uint64_t new_value)
+{
+    if (csr_num >= 0x3b0)
+    {
+        unsigned int i = csr_num - 0x3b0;
+        if ((pmp_regions[i].cfg & 0x80) != 0) return;
+        if (i < 15 && (pmp_regions[i + 1].cfg & 0x98) == 0x88) return;
+        csrs[csr_num] = new_value & 0x3fffffffffffff;
+    }
+    else
+    {
+        uint64_t value = csrs[csr_num];
+        for (unsigned int byte = 0; byte < 8; byte++)
+        {
+            uint64_t cfg = (new_value >> (8 * byte)) & 0x9f;
+            if (((value >> (8 * byte)) & 0x80) != 0) continue;
+            if ((cfg & 0x18) == 0x10) cfg &= ~0x18ULL;
+            if ((cfg & 0x3) == 0x2) cfg &= ~0x2ULL;
+            value = (value & ~(0xffULL << (8 * byte))) | (cfg << (8 * byte));
+        }
+        csrs[csr_num] = value;
+    }
+
+    // pmpaddr holds address bits 55:2, tor regions start at the previous entry's address,
+    // napot regions take their size from the trailing ones
+    pmp_active = false;
+    pmp_locked = false;
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        PmpRegion& region = pmp_regions[i];
+        uint64_t address = csrs[0x3b0 + i];
+        region.cfg = (csrs[0x3a0 + (i / 8) * 2] >> ((i % 8) * 8)) & 0xff;
+        region.low = 0;
+        region.high = 0;
+        if ((region.cfg & 0x18) == 0x08)
+        {
+            region.low = i == 0 ? 0 : (csrs[0x3b0 + i - 1] & ~0x1ULL) << 2;
+            region.high = (address & ~0x1ULL) << 2;
+        }
+        else if ((region.cfg & 0x18) == 0x18)
+        {
+            unsigned int ones = 0;
+            while (ones < 54 && ((address >> ones) & 0x1) == 1) ones++;
+            uint64_t bytes = 1ULL << (ones + 3);
+            region.low = (address << 2) & ~(bytes - 1);
+            region.high = region.low + bytes;
+        }
+        if (region.high <= region.low)
+        {
+            region.low = 0;
+            region.high = 0;
+        }
+        if ((region.cfg & 0x18) != 0)
+        {
+            pmp_active = true;
+            if ((region.cfg & 0x80) != 0) pmp_locked = true;
+        }
+    }
+    for (unsigned int i = 0; i < (1 << pmp_cache_bits); i++) pmp_cache[i].valid = false;
+}
+
+// read doubleword from memory through the data cache model
+uint64_t processor::load_doubleword(uint64_t address)
+{
+    // nothing more is accessed once the instruction has faulted
+    if (access_fault) return 0;
+    loads++;
+
+    // amos need write permission and fault as stores
+    if (paging || pmp_active)
+    {
+        Ins code = decoder->getInsCode();
+        bool amo = (code >= ins_amoswap_w && code <= ins_amomaxu_w) || (code >= ins_amoswap_d && code <= ins_amomaxu_d);
+        uint64_t vaddr = address;
+        if (paging && !translate(vaddr, amo ? 2 : 1, address)) return 0;
+        if (pmp_active && !pmp_check(vaddr, address, amo ? 2 : 1)) return 0;
+    }
+
+    // device registers bypass the caches, and mtime advances every iteration of a loop reading it
+    if (clint != NULL && clint->contains(address))
+    {
+        spin_dirty = true;
+        return clint->read(address,ticks());
+    }
+
+    if (dcache != NULL)
+    {
+        dcache->setTime(cache_time());
+        mem_penalty = dcache->access(address,false,pc);
+    }
+    if (sweep != NULL) sweep->access(address,false);
+    return main_memory->read_doubleword(address);
+}
+
+// write doubleword to memory through the data cache model and check for tohost halt
+void processor::store_doubleword(uint64_t address, uint64_t data, uint64_t mask)
+{
+    spin_dirty = true;
+    if (access_fault) return;
+    stores++;
+    if (address - (address % 8) == reservation) reserved = false;
+    uint64_t vaddr = address;
+    if (paging && !translate(vaddr, 2, address)) return;
+    if (pmp_active && !pmp_check(vaddr, address, 2)) return;
+
+    if (clint != NULL && clint->contains(address))
+    {
+        clint->write(address,data,mask,ticks());
+        update_clint();
+        return;
+    }
+
+    if (dcache != NULL)
+    {
+        dcache->setTime(cache_time());
+        mem_penalty = dcache->access(address,true,pc);
+    }
+    if (sweep != NULL) sweep->access(address,false);
+    main_memory->write_doubleword(address,data,mask);
+
+    if(halt_on_tohost && address - (address % 8) == tohost)
+    {
+        cout << "tohost halt reached at " << setw(16) << setfill('0') << hex << pc
+            << ", tohost = " << setw(16) << setfill('0') << hex << main_memory->read_doubleword(tohost) << endl;
+        halted = true;
+    }
+}
+
+#if ISA_V
+// one vector element operation, on scalars or on GCC vector types of the same element type
+// S is the signed view of V, mask is SEW - 1 to limit shift amounts
+template <typename V, typename S> static V vector_apply(processor::VectorOp op, V a, V b, V d, V mask)
+{
+    switch(op)
+    {
+        case processor::vop_add: return a + b;
+        case processor::vop_sub: return a - b;
+        case processor::vop_rsub: return b - a;
+        case processor::vop_minu: return a < b ? a : b;
+        case processor::vop_min: return (S) a < (S) b ? a : b;
+        case processor::vop_maxu: return a > b ? a : b;
+        case processor::vop_max: return (S) a > (S) b ? a : b;
+        case processor::vop_and: return a & b;
+        case processor::vop_or: return a | b;
+        case processor::vop_xor: return a ^ b;
+        case processor::vop_sll: return a << (b & mask);
+        case processor::vop_srl: return a >> (b & mask);
+        case processor::vop_sra: return (V) ((S) a >> (S) (b & mask));
+        case processor::vop_mul: return a * b;
+        case processor::vop_macc: return d + a * b;
+        default: return b;
+    }
+}
+
+// execute vector instructions
+void processor::executeVector()
+{
+    Ins insCode = decoder->getInsCode();
+    uint64_t vtype = csrs[0xc21];
+    int lmul = (int) (vtype & 0x7) - ((vtype & 0x4) ? 8 : 0);
+    unsigned int group = lmul > 0 ? 1 << lmul : 1;
+    bool masked = ((decoder->getFunct7() & 0x1) == 0);
+
+    // illegal while mstatus.vs is off, before configuration, for misaligned register groups
+    // and when a masked instruction would overwrite the mask in v0
+    if (((csrs[0x300] >> 9) & 0x3) == 0)
+    {
+        except(2);
+        return;
+    }
+    if (insCode > ins_vsetvl)
+    {
+        bool illegal = (vtype >> 63) != 0 || (masked && decoder->getRd() == 0 && insCode < ins_vredsum_vs);
+        if (insCode <= ins_vsse64_v)
+        {
+            // loads and stores use emul = (eew / sew) * lmul
+            int emul = lmul + (int) ((insCode - ins_vle8_v) % 4) - (int) ((vtype >> 3) & 0x7);
+            illegal = illegal || emul < -3 || emul > 3 || (emul > 0 && decoder->getRd() % (1 << emul) != 0);
+        }
+        else if (insCode >= ins_vredsum_vs)
+        {
+            illegal = illegal || decoder->getRs2() % group != 0;
+        }
+        else if (insCode < ins_vmv_x_s)
+        {
+            bool vector_operand = decoder->getFunct3() == 0 || decoder->getFunct3() == 2;
+            illegal = illegal || decoder->getRd() % group != 0 || decoder->getRs2() % group != 0 ||
+                      (vector_operand && decoder->getRs1() % group != 0);
+        }
+        if (illegal)
+        {
+            except(2);
+            return;
+        }
+    }
+
+    switch(insCode)
+    {
+        case ins_vsetvli:
+        case ins_vsetivli:
+        case ins_vsetvl:
+            vector_config();
+            break;
+        case ins_vle8_v: case ins_vle16_v: case ins_vle32_v: case ins_vle64_v:
+            vector_memory(false, 1 << (insCode - ins_vle8_v), 1 << (insCode - ins_vle8_v));
+            break;
+        case ins_vlse8_v: case ins_vlse16_v: case ins_vlse32_v: case ins_vlse64_v:
+            vector_memory(false, 1 << (insCode - ins_vlse8_v), registers[decoder->getRs2()]);
+            break;
+        case ins_vse8_v: case ins_vse16_v: case ins_vse32_v: case ins_vse64_v:
+            vector_memory(true, 1 << (insCode - ins_vse8_v), 1 << (insCode - ins_vse8_v));
+            break;
+        case ins_vsse8_v: case ins_vsse16_v: case ins_vsse32_v: case ins_vsse64_v:
+            vector_memory(true, 1 << (insCode - ins_vsse8_v), registers[decoder->getRs2()]);
+            break;
+        case ins_vmv_x_s:
+            {
+                // element 0 of vs2, sign extended from SEW
+                unsigned int sew = 8 << ((vtype >> 3) & 0x7);
+                uint64_t value = 0;
+                memcpy(&value, &vregisters[decoder->getRs2() * vlenb], sew / 8);
+                if (sew < 64 && ((value >> (sew - 1)) & 0x1)) value |= ~0ULL << sew;
+                set_reg(decoder->getRd(), value);
+            }
+            break;
+        case ins_vmv_s_x:
+            // element 0 of vd when vl is not zero
+            if (csrs[0xc20] > 0 && csrs[0x008] == 0)
+            {
+                uint64_t value = registers[decoder->getRs1()];
+                memcpy(&vregisters[decoder->getRd() * vlenb], &value, 1 << ((vtype >> 3) & 0x7));
+            }
+            csrs[0x008] = 0;
+            break;
+        default:
+            {
+                // element operation from the instruction, the operand form from funct3
+                static const VectorOp ops[] = {
+                    vop_add, vop_add, vop_add, vop_sub, vop_sub, vop_rsub, vop_rsub,
+                    vop_minu, vop_minu, vop_min, vop_min, vop_maxu, vop_maxu, vop_max, vop_max,
+                    vop_and, vop_and, vop_and, vop_or, vop_or, vop_or, vop_xor, vop_xor, vop_xor,
+                    vop_sll, vop_sll, vop_sll, vop_srl, vop_srl, vop_srl, vop_sra, vop_sra, vop_sra,
+                    vop_mul, vop_mul, vop_macc, vop_macc, vop_mv, vop_mv, vop_mv
+                };
+                static const VectorOp reductions[] = {
+                    vop_add, vop_and, vop_or, vop_xor, vop_minu, vop_min, vop_maxu, vop_max
+                };
+                bool reduction = insCode >= ins_vredsum_vs;
+                VectorOp op = reduction ? reductions[insCode - ins_vredsum_vs] : ops[insCode - ins_vadd_vv];
+                switch((vtype >> 3) & 0x7)
+                {
+                    case 0: vector_arith<uint8_t>(op, reduction); break;
+                    case 1: vector_arith<uint16_t>(op, reduction); break;
+                    case 2: vector_arith<uint32_t>(op, reduction); break;
+                    default: vector_arith<uint64_t>(op, reduction); break;
+                }
+            }
+            break;
+    }
+
+    // vector state changed, the spin loop check does not compare vector registers
+    csrs[0x300] |= 0x8000000000000600;
+    spin_dirty = true;
+}
+
+// vsetvli, vsetivli and vsetvl
+void processor::vector_config()
+{
+    Ins insCode = decoder->getInsCode();
+    uint32_t ins = decoder->getIns();
+    uint64_t vtype = insCode == ins_vsetvl ? registers[decoder->getRs2()] :
+                     insCode == ins_vsetivli ? (ins >> 20) & 0x3ff : (ins >> 20) & 0x7ff;
+
+    // vlmax = lmul * vlen / sew, fractional lmul needs sew <= lmul * elen
+    unsigned int sew = 8 << ((vtype >> 3) & 0x7);
+    int lmul = (int) (vtype & 0x7) - ((vtype & 0x4) ? 8 : 0);
+    uint64_t vlmax = lmul >= 0 ? ((uint64_t) vlenb * 8 / sew) << lmul : ((uint64_t) vlenb * 8 / sew) >> -lmul;
+    bool valid = sew <= 64 && lmul != -4 && (vtype >> 8) == 0 && vlmax > 0 && (lmul >= 0 || sew <= (64u >> -lmul));
+
+    // application vector length from rs1 or the immediate, x0 asks for vlmax or keeps vl
+    uint64_t avl;
+    if (insCode == ins_vsetivli) avl = decoder->getRs1();
+    else if (decoder->getRs1() != 0) avl = registers[decoder->getRs1()];
+    else if (decoder->getRd() != 0) avl = UINT64_MAX;
+    else avl = csrs[0xc20];
+
+    if (valid)
+    {
+        csrs[0xc21] = vtype;
+        csrs[0xc20] = avl < vlmax ? avl : vlmax;
+    }
+    else
+    {
+        csrs[0xc21] = 0x8000000000000000;
+        csrs[0xc20] = 0;
+    }
+    csrs[0x008] = 0;
+    set_reg(decoder->getRd(), csrs[0xc20]);
+}
+
+// unit-stride and strided loads and stores of eew-byte elements
+// elements sharing a doubleword are read once or merged into one write through the cache model
+void processor::vector_memory(bool store, unsigned int eew, uint64_t stride)
+{
+    uint64_t vl = csrs[0xc20];
+    uint64_t base = registers[decoder->getRs1()];
+    bool masked = ((decoder->getFunct7() & 0x1) == 0);
+    uint8_t* group = &vregisters[decoder->getRd() * vlenb];
+    uint64_t element_mask = eew == 8 ? 0xffffffffffffffff : (1ULL << (eew * 8)) - 1;
+    uint64_t line = UINT64_MAX;
+    uint64_t data = 0;
+    uint64_t mask = 0;
+    uint64_t first = 0;         // first element merged into data
+    unsigned int penalty = 0;
+
+    // misaligned elements trap before any access
+    if (base % eew != 0 || stride % eew != 0)
+    {
+        except(store ? 6 : 4);
+        return;
+    }
+
+    for (uint64_t i = csrs[0x008]; i < vl; i++)
+    {
+        if (masked && ((vregisters[i / 8] >> (i % 8)) & 0x1) == 0) continue;
+
+        uint64_t address = base + i * stride;
+        uint64_t doubleword = address - (address % 8);
+        unsigned int shift = address % 8 * 8;
+        uint64_t value = 0;
+
+        if (!store)
+        {
+            if (doubleword != line)
+            {
+                data = load_doubleword(address);
+                penalty += mem_penalty;
+                line = doubleword;
+
+                // a page fault resumes from this element
+                if (access_fault)
+                {
+                    csrs[0x008] = i;
+                    return;
+                }
+            }
+            value = data >> shift;
+            memcpy(group + i * eew, &value, eew);
+        }
+        else
+        {
+            if (doubleword != line && mask != 0)
+            {
+                store_doubleword(line, data, mask);
+                penalty += mem_penalty;
+                data = 0;
+                mask = 0;
+
+                // a page fault resumes from the first element of the doubleword
+                if (access_fault)
+                {
+                    csrs[0x008] = first;
+                    return;
+                }
+            }
+            if (mask == 0) first = i;
+            line = doubleword;
+            memcpy(&value, group + i * eew, eew);
+            data = (data & ~(element_mask << shift)) | (value << shift);
+            mask |= element_mask << shift;
+        }
+    }
+    if (store && mask != 0)
+    {
+        store_doubleword(line, data, mask);
+        penalty += mem_penalty;
+        if (access_fault)
+        {
+            csrs[0x008] = first;
+            return;
+        }
+    }
+
+    mem_penalty = penalty;
+    csrs[0x008] = 0;
+}
+
+// element-wise arithmetic, or a reduction into element 0 of vd, on sew-bit elements of type T
+// unmasked loops from element 0 run 16 bytes at a time on GCC vector types, which the compiler
+// maps to SSE2 or AVX2 where available and to scalar code elsewhere; the rest run per element
+template <typename T> void processor::vector_arith(VectorOp op, bool reduction)
+{
+    typedef typename make_signed<T>::type S;
+    uint8_t* vd = &vregisters[decoder->getRd() * vlenb];
+    uint8_t* vs2 = &vregisters[decoder->getRs2() * vlenb];
+    uint8_t* vs1 = &vregisters[decoder->getRs1() * vlenb];
+    uint64_t vl = csrs[0xc20];
+    uint64_t i = csrs[0x008];
+    bool masked = ((decoder->getFunct7() & 0x1) == 0);
+    const T mask = sizeof(T) * 8 - 1;
+
+    // the second operand is vs1, x[rs1] or a 5-bit immediate, unsigned for shifts
+    bool vector_operand = decoder->getFunct3() == 0 || decoder->getFunct3() == 2;
+    T scalar;
+    if (decoder->getFunct3() == 3)
+    {
+        uint64_t imm = decoder->getRs1();
+        if (op != vop_sll && op != vop_srl && op != vop_sra && (imm & 0x10)) imm |= ~0x1fULL;
+        scalar = (T) imm;
+    }
+    else
+    {
+        scalar = (T) registers[decoder->getRs1()];
+    }
+
+    if (reduction)
+    {
+        // vd[0] = vs1[0] op vs2[active elements]
+        T acc;
+        memcpy(&acc, vs1, sizeof(T));
+        for (; i < vl; i++)
+        {
+            if (masked && ((vregisters[i / 8] >> (i % 8)) & 0x1) == 0) continue;
+            T a;
+            memcpy(&a, vs2 + i * sizeof(T), sizeof(T));
+            acc = vector_apply<T, S>(op, a, acc, 0, mask);
+        }
+        if (vl > 0) memcpy(vd, &acc, sizeof(T));
+        csrs[0x008] = 0;
+        return;
+    }
+
+#ifdef __GNUC__
+    if (!masked)
+    {
+        typedef T VT __attribute__((vector_size(16)));
+        typedef S VS __attribute__((vector_size(16)));
+        const uint64_t lanes = 16 / sizeof(T);
+        VT vmask = VT{} + mask;
+        VT vscalar = VT{} + scalar;
+        for (; i + lanes <= vl; i += lanes)
+        {
+            VT a, b, d;
+            memcpy(&a, vs2 + i * sizeof(T), 16);
+            memcpy(&d, vd + i * sizeof(T), 16);
+            if (vector_operand) memcpy(&b, vs1 + i * sizeof(T), 16);
+            else b = vscalar;
+            d = vector_apply<VT, VS>(op, a, b, d, vmask);
+            memcpy(vd + i * sizeof(T), &d, 16);
+        }
+    }
+#endif
+
+    for (; i < vl; i++)
+    {
+        if (masked && ((vregisters[i / 8] >> (i % 8)) & 0x1) == 0) continue;
+        T a, b, d;
+        memcpy(&a, vs2 + i * sizeof(T), sizeof(T));
+        memcpy(&d, vd + i * sizeof(T), sizeof(T));
+        if (vector_operand) memcpy(&b, vs1 + i * sizeof(T), sizeof(T));
+        else b = scalar;
+        d = vector_apply<T, S>(op, a, b, d, mask);
+        memcpy(vd + i * sizeof(T), &d, sizeof(T));
+    }
+    csrs[0x008] = 0;
+}
+#endif
+
+#if ISA_FD
+// raw bits of a float or double
+static uint64_t fp_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static uint64_t fp_bits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// nan tests on the bits, as host comparisons raise invalid for signalling nans
+template <typename T> static bool fp_is_nan(T value)
+{
+    const int mantissa = sizeof(T) == 4 ? 23 : 52;
+    const uint64_t exponent_mask = sizeof(T) == 4 ? 0xff : 0x7ff;
+    uint64_t bits = fp_bits(value);
+    return ((bits >> mantissa) & exponent_mask) == exponent_mask && (bits & ((1ULL << mantissa) - 1)) != 0;
+}
+
+template <typename T> static bool fp_is_signalling(T value)
+{
+    const int mantissa = sizeof(T) == 4 ? 23 : 52;
+    return fp_is_nan(value) && ((fp_bits(value) >> (mantissa - 1)) & 0x1) == 0;
+}
 
-                // set mpp = 0
-                csrs[0x300] &= 0xffffffffffffe7ff;
+// arithmetic results that are nan are replaced by the canonical nan
+template <typename T> static T fp_canonical(T value)
+{
+    return fp_is_nan(value) ? numeric_limits<T>::quiet_NaN() : value;
+}
 
-                // set mie to mpie
-                if(((csrs[0x300] >> 7) & 0x1) == 1)
-                {
-                    // mie = 1
-                    csrs[0x300] |= 0x8;
-                }
-                else
-                {
-                    // mie = 0
-                    csrs[0x300] &= 0xfffffffffffffff7;
-                }
+// fclass result bit
+template <typename T> static uint64_t fp_class(T value)
+{
+    const int mantissa = sizeof(T) == 4 ? 23 : 52;
+    const uint64_t exponent_mask = sizeof(T) == 4 ? 0xff : 0x7ff;
+    uint64_t bits = fp_bits(value);
+    bool negative = (bits >> (sizeof(T) * 8 - 1)) & 0x1;
+    uint64_t exponent = (bits >> mantissa) & exponent_mask;
+    uint64_t fraction = bits & ((1ULL << mantissa) - 1);
+
+    if (exponent == exponent_mask)
+    {
+        if (fraction == 0) return negative ? 0x001 : 0x080;
+        return fp_is_signalling(value) ? 0x100 : 0x200;
+    }
+    if (exponent == 0) 
+    {
+        if (fraction == 0) return negative ? 0x008 : 0x010;
+        return negative ? 0x004 : 0x020;
+    }
+    return negative ? 0x002 : 0x040;
+}
 
-                // set mpie = 0
-                csrs[0x300] |= 0x80;
-            }
-            break;
-        case ins_csrrw:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+// execute F and D instructions
+void processor::executeFloat()
+{
+    Ins insCode = decoder->getInsCode();
+    uint64_t tmp;
+    uint64_t mask;
+
+    // illegal while mstatus.fs is off
+    if (((csrs[0x300] >> 13) & 0x3) == 0)
+    {
+        except(2);
+        return;
+    }
+
+    switch(insCode)
+    {
+        case ins_flw:
+            tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
+            if (tmp % 4 == 0)
             {
-                except(2);
+                tmp = load_doubleword(tmp) >> (tmp % 8 * 8);
+                if (!access_fault) fregisters[decoder->getRd()] = 0xffffffff00000000 | (tmp & 0xffffffff);
             }
             else
             {
-                tmp = registers[decoder->getRs1()];
-                if(csr_num == 0x344) tmp &= 0x111;
-
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                set_csr(csr_num,tmp);
+                except(4);
+                return;
             }
             break;
-        case ins_csrrs:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+        case ins_fld:
+            tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
+            if (tmp % 8 == 0)
             {
-                except(2);
+                tmp = load_doubleword(tmp);
+                if (!access_fault) fregisters[decoder->getRd()] = tmp;
             }
             else
             {
-                tmp = csrs[csr_num] | registers[decoder->getRs1()];
-                if(csr_num == 0x344) tmp &= 0x111;
-
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                if(decoder->getRs1() != 0) set_csr(csr_num,tmp);
+                except(4);
+                return;
             }
             break;
-        case ins_csrrc:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+        case ins_fsw:
+            tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
+            if (tmp % 4 == 0)
             {
-                except(2);
+                mask = 0xffffffff;
+                mask <<= (tmp % 8 * 8);
+                store_doubleword(tmp,(fregisters[decoder->getRs2()] & 0xffffffff) << (tmp % 8 * 8),mask);
             }
             else
             {
-                tmp = csrs[csr_num] & (~registers[decoder->getRs1()]);
-                if(csr_num == 0x344) tmp &= 0x111;
-
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                if(decoder->getRs1() != 0) set_csr(csr_num,tmp);
+                except(6);
             }
-            break;
-        case ins_csrrwi:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+            return;
+        case ins_fsd:
+            tmp = registers[decoder->getRs1()] + sext_32_64(sext_12_32(decoder->getImm()));
+            if (tmp % 8 == 0)
             {
-                except(2);
+                store_doubleword(tmp,fregisters[decoder->getRs2()],0xffffffffffffffff);
             }
             else
             {
-                tmp = decoder->getRs1();
-                if(csr_num == 0x344) tmp &= 0x111;
+                except(6);
+            }
+            return;
+        default:
+            {
+                // single and double forms share a layout
+                bool dbl = insCode >= ins_fmadd_d;
+                Ins op = dbl ? (Ins) (insCode - ins_fmadd_d + ins_fmadd_s) : insCode;
+
+                // operations up to the conversions take a rounding mode, 7 selects frm
+                if (op <= ins_fcvt_s_d)
+                {
+                    uint8_t rm = decoder->getFunct3();
+                    if (rm == 7) rm = csrs[0x002];
+                    if (rm > 4)
+                    {
+                        except(2);
+                        return;
+                    }
+                    set_round(rm);
+                }
 
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                set_csr(csr_num,tmp);
+                if (dbl)
+                {
+                    executeFloatOp<double>(op);
+                }
+                else
+                {
+                    executeFloatOp<float>(op);
+                }
             }
             break;
-        case ins_csrrsi:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+    }
+
+    // fp state changed, the spin loop check does not compare fp registers
+    csrs[0x300] |= 0x8000000000006000;
+    spin_dirty = true;
+}
+
+// execute an F or D operation on single or double values, op is the single form
+template <typename T> void processor::executeFloatOp(Ins op)
+{
+    uint8_t rd = decoder->getRd();
+    uint8_t rs1 = decoder->getRs1();
+    uint8_t rs2 = decoder->getRs2();
+    uint8_t rm = decoder->getFunct3() == 7 ? csrs[0x002] : decoder->getFunct3();
+    const unsigned int bits = sizeof(T) * 8;
+    T a, b, c;
+    read_freg(rs1, a);
+    read_freg(rs2, b);
+    read_freg(decoder->getRs3(), c);
+
+    switch(op)
+    {
+        case ins_fmadd_s:
+            write_freg(rd, fp_canonical(fma(a, b, c)));
+            break;
+        case ins_fmsub_s:
+            write_freg(rd, fp_canonical(fma(a, b, -c)));
+            break;
+        case ins_fnmsub_s:
+            write_freg(rd, fp_canonical(fma(-a, b, c)));
+            break;
+        case ins_fnmadd_s:
+            write_freg(rd, fp_canonical(fma(-a, b, -c)));
+            break;
+        case ins_fadd_s:
+            write_freg(rd, fp_canonical(a + b));
+            break;
+        case ins_fsub_s:
+            write_freg(rd, fp_canonical(a - b));
+            break;
+        case ins_fmul_s:
+            write_freg(rd, fp_canonical(a * b));
+            break;
+        case ins_fdiv_s:
+            write_freg(rd, fp_canonical(a / b));
+            break;
+        case ins_fsqrt_s:
+            write_freg(rd, fp_canonical(sqrt(a)));
+            break;
+        case ins_fcvt_w_s:
+            set_reg(rd, float_to_int(a, true, 32, rm));
+            break;
+        case ins_fcvt_wu_s:
+            set_reg(rd, float_to_int(a, false, 32, rm));
+            break;
+        case ins_fcvt_l_s:
+            set_reg(rd, float_to_int(a, true, 64, rm));
+            break;
+        case ins_fcvt_lu_s:
+            set_reg(rd, float_to_int(a, false, 64, rm));
+            break;
+        case ins_fcvt_s_w:
+            write_freg(rd, (T) (int32_t) registers[rs1]);
+            break;
+        case ins_fcvt_s_wu:
+            write_freg(rd, (T) (uint32_t) registers[rs1]);
+            break;
+        case ins_fcvt_s_l:
+            write_freg(rd, (T) (int64_t) registers[rs1]);
+            break;
+        case ins_fcvt_s_lu:
+            write_freg(rd, (T) registers[rs1]);
+            break;
+        case ins_fcvt_s_d:
+            // fcvt.s.d narrows and fcvt.d.s widens
+            if (bits == 32)
             {
-                except(2);
+                double source;
+                read_freg(rs1, source);
+                write_freg(rd, fp_canonical((T) source));
             }
             else
             {
-                tmp = csrs[csr_num] | decoder->getRs1();
-                if(csr_num == 0x344) tmp &= 0x111;
-
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                if(decoder->getRs1() != 0) set_csr(csr_num,tmp);
+                float source;
+                read_freg(rs1, source);
+                write_freg(rd, fp_canonical((T) source));
             }
             break;
-        case ins_csrrci:
-            csr_num = decoder->getImm();
-            if(prv == 0 || csrs.find(csr_num) == csrs.end() || 
-                (csr_num == 0xf11 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf12 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf13 && decoder->getRs1() != 0) || 
-                (csr_num == 0xf14 && decoder->getRs1() != 0))
+        case ins_fsgnj_s:
+            write_freg(rd, copysign(a, b));
+            break;
+        case ins_fsgnjn_s:
+            write_freg(rd, copysign(a, signbit(b) ? (T) 1 : (T) -1));
+            break;
+        case ins_fsgnjx_s:
+            write_freg(rd, copysign(a, signbit(a) != signbit(b) ? (T) -1 : (T) 1));
+            break;
+        case ins_fmin_s:
+        case ins_fmax_s:
             {
-                except(2);
+                // a nan operand returns the other, -0 orders below +0
+                bool max = op == ins_fmax_s;
+                T result;
+                if (fp_is_signalling(a) || fp_is_signalling(b)) feraiseexcept(FE_INVALID);
+                if (fp_is_nan(a) && fp_is_nan(b)) result = numeric_limits<T>::quiet_NaN();
+                else if (fp_is_nan(a)) result = b;
+                else if (fp_is_nan(b)) result = a;
+                else if (a == b) result = (signbit(a) != max) ? a : b;
+                else result = ((a < b) != max) ? a : b;
+                write_freg(rd, result);
+            }
+            break;
+        case ins_feq_s:
+            if (fp_is_signalling(a) || fp_is_signalling(b)) feraiseexcept(FE_INVALID);
+            set_reg(rd, !fp_is_nan(a) && !fp_is_nan(b) && a == b);
+            break;
+        case ins_flt_s:
+        case ins_fle_s:
+            if (fp_is_nan(a) || fp_is_nan(b))
+            {
+                feraiseexcept(FE_INVALID);
+                set_reg(rd, 0);
             }
             else
             {
-                tmp = csrs[csr_num] & (~decoder->getRs1());
-                if(csr_num == 0x344) tmp &= 0x111;
-
-                set_reg(decoder->getRd(),csrs[csr_num]);
-                if(decoder->getRs1() != 0) set_csr(csr_num,tmp);
+                set_reg(rd, op == ins_flt_s ? a < b : a <= b);
             }
             break;
+        case ins_fclass_s:
+            set_reg(rd, fp_class(a));
+            break;
+        case ins_fmv_x_w:
+            // the raw register bits, a single is sign extended
+            set_reg(rd, bits == 32 ? sext_32_64(fregisters[rs1] & 0xffffffff) : fregisters[rs1]);
+            break;
+        case ins_fmv_w_x:
+            fregisters[rd] = bits == 32 ? 0xffffffff00000000 | (registers[rs1] & 0xffffffff) : registers[rs1];
+            break;
         default:
             break;
     }
-    
-    // increment program counter
-    pc += 4;
 }
 
+// convert to an integer of bits width, saturating and raising invalid as RISC-V requires
+template <typename T> uint64_t processor::float_to_int(T value, bool is_signed, unsigned int bits, uint8_t rm)
+{
+    // limits as powers of two, exact in either type
+    T high = ldexp((T) 1, is_signed ? bits - 1 : bits);
+    T low = is_signed ? -high : 0;
+    uint64_t max_result = is_signed ? (bits == 32 ? 0x7fffffff : 0x7fffffffffffffff) : 0xffffffffffffffff;
+    uint64_t min_result = is_signed ? (bits == 32 ? 0xffffffff80000000 : 0x8000000000000000) : 0;
+
+    if (fp_is_nan(value))
+    {
+        feraiseexcept(FE_INVALID);
+        return max_result;
+    }
+
+    // rmm has no host rounding mode, round() breaks ties away from zero
+    T rounded = rm == 4 ? round(value) : nearbyint(value);
+    if (rounded < low)
+    {
+        feraiseexcept(FE_INVALID);
+        return min_result;
+    }
+    if (rounded >= high)
+    {
+        feraiseexcept(FE_INVALID);
+        return max_result;
+    }
+    if (rounded != value) feraiseexcept(FE_INEXACT);
+
+    if (is_signed) return bits == 32 ? sext_32_64((uint32_t) (int64_t) rounded) : (uint64_t) (int64_t) rounded;
+    return bits == 32 ? sext_32_64((uint32_t) (uint64_t) rounded) : (uint64_t) rounded;
+}
+#endif
+
+// set the host rounding mode for rm
+void processor::set_round(uint8_t rm)
+{
+    // rne, rtz, rdn, rup, and rmm approximated by rne
+    static const int modes[5] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST };
+    if (rm == host_round) return;
+    fesetround(modes[rm]);
+    host_round = rm;
+}
+
+// fold host floating point exception flags into fflags and clear them
+// host flags accrue across instructions and are only read here, before fflags is used
+void processor::sync_fflags()
+{
+    if (!Isa::fd) return;
+    int raised = fetestexcept(FE_ALL_EXCEPT);
+    if (raised == 0) return;
+
+    uint64_t flags = 0;
+    if (raised & FE_INVALID) flags |= 0x10;
+    if (raised & FE_DIVBYZERO) flags |= 0x08;
+    if (raised & FE_OVERFLOW) flags |= 0x04;
+    if (raised & FE_UNDERFLOW) flags |= 0x02;
+    if (raised & FE_INEXACT) flags |= 0x01;
+    feclearexcept(FE_ALL_EXCEPT);
+
+    if ((csrs[0x001] | flags) != csrs[0x001]) set_csr(0x001, csrs[0x001] | flags);
+}
+
+#if ISA_FD
+// read floating point registers, singles that are not NaN-boxed read as the canonical NaN
+void processor::read_freg(unsigned int reg, float& value)
+{
+    uint64_t bits = fregisters[reg];
+    uint32_t single = (bits >> 32) == 0xffffffff ? bits & 0xffffffff : 0x7fc00000;
+    memcpy(&value, &single, sizeof(value));
+}
+
+void processor::read_freg(unsigned int reg, double& value)
+{
+    memcpy(&value, &fregisters[reg], sizeof(value));
+}
+
+// write floating point registers, NaN-boxing singles
+void processor::write_freg(unsigned int reg, float value)
+{
+    fregisters[reg] = 0xffffffff00000000 | fp_bits(value);
+}
+
+void processor::write_freg(unsigned int reg, double value)
+{
+    fregisters[reg] = fp_bits(value);
+}
+#endif
+
 // sign extend 12-bit to 32-bit
 uint32_t processor::sext_12_32(uint32_t val)
 {
@@ -962,23 +3033,78 @@ bool processor::signedComp(uint64_t a, uint64_t b)
 // initialise control and status registers
 void processor::initCSRs()
 {
+    if (Isa::fd)
+    {
+        csrs.insert(make_pair(0x001,0x0000000000000000));   // fflags
+        csrs.insert(make_pair(0x002,0x0000000000000000));   // frm
+        csrs.insert(make_pair(0x003,0x0000000000000000));   // fcsr
+    }
+    if (Isa::v)
+    {
+        csrs.insert(make_pair(0x008,0x0000000000000000));   // vstart
+        csrs.insert(make_pair(0xc20,0x0000000000000000));   // vl
+        csrs.insert(make_pair(0xc21,0x8000000000000000));   // vtype, vill until configured
+        csrs.insert(make_pair(0xc22,vlenb));                // vlenb
+    }
     csrs.insert(make_pair(0xf11,0x0000000000000000));   // mvendorid
     csrs.insert(make_pair(0xf12,0x0000000000000000));   // marchid
     csrs.insert(make_pair(0xf13,0x2020020000000000));   // mimpid
     csrs.insert(make_pair(0xf14,0x0000000000000000));   // mhartid
+    csrs.insert(make_pair(0x100,0x0000000000000000));   // sstatus, view of mstatus
+    csrs.insert(make_pair(0x104,0x0000000000000000));   // sie, view of mie
+    csrs.insert(make_pair(0x105,0x0000000000000000));   // stvec
+    csrs.insert(make_pair(0x106,0x00000000ffffffff));   // scounteren
+    csrs.insert(make_pair(0x140,0x0000000000000000));   // sscratch
+    csrs.insert(make_pair(0x141,0x0000000000000000));   // sepc
+    csrs.insert(make_pair(0x142,0x0000000000000000));   // scause
+    csrs.insert(make_pair(0x143,0x0000000000000000));   // stval
+    csrs.insert(make_pair(0x144,0x0000000000000000));   // sip, view of mip
+    csrs.insert(make_pair(0x180,0x0000000000000000));   // satp
     csrs.insert(make_pair(0x300,0x0000000200000000));   // mstatus
-    csrs.insert(make_pair(0x301,0x8000000000100100));   // misa 
+    csrs[0x301] = Isa::misa;                            // misa
     csrs.insert(make_pair(0x304,0x0000000000000000));   // mie
+    csrs.insert(make_pair(0x302,0x0000000000000000));   // medeleg
+    csrs.insert(make_pair(0x303,0x0000000000000000));   // mideleg
     csrs.insert(make_pair(0x305,0x0000000000000000));   // mtvec
+    csrs.insert(make_pair(0x306,0x00000000ffffffff));   // mcounteren
     csrs.insert(make_pair(0x340,0x0000000000000000));   // mscratch  
     csrs.insert(make_pair(0x341,0x0000000000000000));   // mepc
     csrs.insert(make_pair(0x342,0x0000000000000000));   // mcause
     csrs.insert(make_pair(0x343,0x0000000000000000));   // mtval
     csrs.insert(make_pair(0x344,0x0000000000000000));   // mip
+    csrs.insert(make_pair(0x3a0,0x0000000000000000));   // pmpcfg0, entries 0-7
+    csrs.insert(make_pair(0x3a2,0x0000000000000000));   // pmpcfg2, entries 8-15
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        csrs.insert(make_pair(0x3b0 + i,0x0000000000000000));   // pmpaddr0-15
+    }
+
+    // counters are computed on read, mhpmevent3-31 select their events
+    for (unsigned int i = 0; i < 32; i++)
+    {
+        csrs.insert(make_pair(0xc00 + i,0x0000000000000000));   // cycle, time, instret, hpmcounter3-31
+        if (i != 1) csrs.insert(make_pair(0xb00 + i,0x0000000000000000));   // mcycle, minstret, mhpmcounter3-31
+        if (i >= 3) csrs.insert(make_pair(0x320 + i,0x0000000000000000));   // mhpmevent3-31
+    }
+}
+
+// jump or take a branch to target, linking rd, raising a misaligned exception on the jump itself
+// when target is not on an instruction boundary
+void processor::jump(uint64_t target, unsigned int rd)
+{
+    if (target % (Isa::c ? 2 : 4) != 0)
+    {
+        // mepc is the jump, which does not retire
+        except(0, target);
+        ins_count--;
+        return;
+    }
+    set_reg(rd, pc + decoder->getInsLength());
+    pc = target;
 }
 
 // return from machine trap
-void processor::except(int cause)
+void processor::except(int cause, uint64_t tval)
 {
     if(verbose)
     {
@@ -988,97 +3114,138 @@ void processor::except(int cause)
     }
 
     uint64_t old_pc = pc;
+    trapped = true;
+    traps++;
 
-    // store old pc into mepc
-    set_csr(0x341,old_pc);
-
-    // set mcause to cause
-    set_csr(0x342,cause);
+    // trap value by cause
+    switch(cause)
+    {
+        case 0:
+            // instruction address misaligned
+            // misaligned pc or jump target, passed in tval
+            break;
+        case 2:
+            // illegal instruction
+            // instruction
+            tval = decoder->getIns();
+            break;
+        case 4:
+            // load address misaligned
+            // misaligned address
+            tval = registers[decoder->getRs1()];
+            break;
+        case 6:
+            // store address misaligned
+            // misaligned address
+            tval = registers[decoder->getRs1()];
+            break;
+        case 1:
+        case 5:
+        case 7:
+        case 12:
+        case 13:
+        case 15:
+            // instruction, load and store access and page faults
+            // faulting virtual address
+            break;
+        default:
+            tval = 0;
+            break;
+    }
 
-    // set pc to mtvec
-    if((csrs[0x305] & 0x1) == 0)
+    if(prv != 3 && ((csrs[0x302] >> cause) & 0x1) == 1)
     {
-        // direct mode, all exceptions set pc to BASE
-        pc = (csrs[0x305] & 0xfffffffffffffffc);
+        // delegated in medeleg
+        supervisor_trap(cause,tval);
     }
     else
     {
-        // vector mode, asynchronous interrupts set pc to BASE+4×cause
-        pc = (csrs[0x305] & 0xfffffffffffffffc) + (4 * (cause & 0x0));
-    }
+        // store old pc into mepc
+        set_csr(0x341,old_pc);
 
-    // set mstatus by priviledge
-    if(prv == 0)
-    {
-        // set mpp = 0
-        csrs[0x300] &= 0xffffffffffffe7ff;
+        // set mcause to cause
+        set_csr(0x342,cause);
+
+        // set mtval to trap value
+        set_csr(0x343,tval);
+
+        // set pc to mtvec
+        if((csrs[0x305] & 0x1) == 0)
+        {
+            // direct mode, all exceptions set pc to BASE
+            pc = (csrs[0x305] & 0xfffffffffffffffc);
+        }
+        else
+        {
+            // vector mode, asynchronous interrupts set pc to BASE+4×cause
+            pc = (csrs[0x305] & 0xfffffffffffffffc) + (4 * (cause & 0x0));
+        }
 
-        // set mpie
-        if(((csrs[0x300] >> 3) & 0x1) == 1)
+        // set mstatus by priviledge
+        if(prv != 3)
         {
-            // mpie = 1
-            csrs[0x300] |= 0x80;
+            // set mpp = 0 from user, 1 from supervisor
+            csrs[0x300] = (csrs[0x300] & 0xffffffffffffe7ff) | ((uint64_t)prv << 11);
+
+            // set mpie
+            if(((csrs[0x300] >> 3) & 0x1) == 1)
+            {
+                // mpie = 1
+                csrs[0x300] |= 0x80;
+            }
+            else
+            {
+                // mpie = 0
+                csrs[0x300] &= 0xffffffffffffff7f;
+            }
+
+            // set mie = 0
+            csrs[0x300] &= 0xfffffffffffffff7;
         }
         else
         {
+            // set mpp = 3
+            csrs[0x300] |= 0x1800;
+
             // mpie = 0
             csrs[0x300] &= 0xffffffffffffff7f;
         }
 
-        // set mie = 0
-        csrs[0x300] &= 0xfffffffffffffff7;
+        // set priviledge to machine
+        set_prv(3);
     }
-    else if(prv == 3)
+
+    // instruction misaligned, fetch access and fetch page faults happen before an instruction executes,
+    // others undo the pc increment and count of the trapping instruction, and jump() undoes the count
+    // of a jump to a misaligned target
+    if(cause != 0 && cause != 1 && cause != 12)
     {
-        // set mpp = 3
-        csrs[0x300] |= 0x1800;
+        // decrement pc
+        pc -= decoder->getInsLength();
 
-        // mpie = 0
-        csrs[0x300] &= 0xffffffffffffff7f;
+        // decrement instruction count
+        ins_count --;
     }
+}
 
-    switch(cause)
-    {
-        case 0:
-            // instruction address misaligned
-            ins_count ++;
-            pc += 4;
-            // set mtval to misaligned pc
-            set_csr(0x343,old_pc);
-            break;
-        case 2:
-            // illegal instruction
-            // set mtval to instruction
-            set_csr(0x343,decoder->getIns());
-            break;
-        case 4:
-            // load address misaligned
-            // set mtval to misaligned address
-            set_csr(0x343,registers[decoder->getRs1()]);
-            break;
-        case 6:
-            // store address misaligned
-            // set mtval to misaligned address
-            set_csr(0x343,registers[decoder->getRs1()]);
-            break;
-        case 8:
-            // ecall in user mode
-            set_csr(0x343,0);
-            set_prv(3);
-            break;
-        case 11:
-            // ecall in machine mode
-            set_csr(0x343,0);
-            break;
-        default:
-            break;
-    }
+// take a trap delegated to supervisor mode
+void processor::supervisor_trap(uint64_t cause, uint64_t tval)
+{
+    // sepc, scause and stval
+    set_csr(0x141,pc);
+    set_csr(0x142,cause);
+    set_csr(0x143,tval);
+
+    // spp = previous privilege, spie = sie, sie = 0
+    uint64_t status = csrs[0x300] & 0xfffffffffffffedd;
+    status |= ((uint64_t)prv << 8) | ((csrs[0x300] & 0x2) << 4);
+    csrs[0x300] = status;
 
-    // decrement pc
-    pc -= 4;
+    // set pc to stvec, vectored mode sends interrupts to BASE+4×cause
+    pc = csrs[0x105] & 0xfffffffffffffffc;
+    if((csrs[0x105] & 0x1) == 1 && (cause >> 63) == 1) pc += 4 * (cause & 0x3f);
 
-    // decrement instruction count
-    ins_count --;
+    set_prv(1);
 }
 
 void processor::interrupt(int cause)
@@ -1089,6 +3256,16 @@ void processor::interrupt(int cause)
             << ", pc = " << setw(16) << setfill('0') << hex << pc << endl;
     }
 
+    trapped = true;
+    traps++;
+
+    // delegated in mideleg
+    if(((csrs[0x303] >> cause) & 0x1) == 1)
+    {
+        supervisor_trap(0x8000000000000000 + cause,0);
+        return;
+    }
+
     // set mpie = 1
     csrs[0x300] |= 0x80;
 
@@ -1110,9 +3287,12 @@ void processor::interrupt(int cause)
         pc = (csrs[0x305] & 0xfffffffffffffffc) + (4 * cause);
     }
 
-    if(prv == 0)
+    if(prv != 3)
     {
-        // user mode
+        // user or supervisor mode
+
+        // set mpp to the previous mode
+        csrs[0x300] = (csrs[0x300] & 0xffffffffffffe7ff) | ((uint64_t)prv << 11);
 
         // switch to machine mode
         set_prv(3);
@@ -1163,4 +3343,5 @@ void processor::interrupt(int cause)
 processor::~processor()
 {
     delete decoder;
+    delete events;
 }
\ No newline at end of file
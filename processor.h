@@ -8,6 +8,14 @@
 
 #include "memory.h"
 #include "Decoder.h"
+#include "TimingModel.h"
+#include "Cache.h"
+#include "CacheSweep.h"
+#include "BranchUnit.h"
+#include "TimingThread.h"
+#include "CostModel.h"
+#include "Clint.h"
+#include "EventQueue.h"
 
 using namespace std;
 
@@ -29,9 +37,123 @@ class processor {
   uint64_t ins_count;
   uint64_t registers[32];
 
+  // floating point registers, singles are NaN-boxed with the upper 32 bits set
+  uint64_t fregisters[32];
+  int host_round;             // rm last set on the host FPU
+
+  // vector registers of vlenb bytes each, stored in order so register groups are contiguous
+  vector<uint8_t> vregisters;
+  unsigned int vlenb;
+
+  // run halt conditions
+  bool halt_on_ebreak;
+  bool halt_on_ecall;
+  uint64_t halt_ecall_a7;
+  bool halt_on_tohost;
+  uint64_t tohost;
+  uint64_t halt_count;
+  uint64_t halt_time;
+  bool halted;
+  bool running;
+
+  // host time spent executing instructions
+  double host_seconds;
+
   // instruction decoder
   Decoder* decoder;
 
+  // timing model, NULL when disabled
+  TimingModel* timing;
+  bool trapped;
+
+  // cache models, NULL when disabled
+  Cache* icache;
+  Cache* dcache;
+  unsigned int mem_penalty;
+  CacheSweep* sweep;
+
+  // branch prediction, NULL when disabled
+  BranchUnit* branch_unit;
+
+  // consumer thread for retired instructions, NULL when timing runs inline
+  TimingThread* timing_thread;
+
+  // analytical cycle estimate, NULL when disabled
+  CostModel* cost_model;
+
+  // device and scripted events, timed in instructions
+  EventQueue* events;
+
+  // timer device, NULL when disabled
+  Clint* clint;
+  uint64_t clint_generation;  // invalidates expiry events scheduled before an update
+
+  // time skipped while waiting in wfi, device time is ins_count + idle_ticks
+  uint64_t idle_ticks;
+
+  // spin loop detection, comparing state at successive iterations of a short backward loop
+  bool skip_spin_enabled;
+  uint64_t spin_branch;       // pc of the backward transfer
+  uint64_t spin_target;
+  uint64_t spin_start;        // ins_count at the start of the iteration
+  bool spin_dirty;            // iteration stored, wrote a csr, read a counter or mtime, or trapped
+  uint64_t spin_registers[32];
+  uint64_t spin_skipped;
+
+  // lr reservation, with a single hart any store to the reserved doubleword clears it
+  bool reserved;
+  uint64_t reservation;
+
+  // events for the hardware performance monitor, counted only where they happen
+  uint64_t loads;             // data memory reads, one per doubleword accessed
+  uint64_t stores;
+  uint64_t branches_taken;
+  uint64_t traps;
+
+  // counters are read as their event source minus a base, so writes only move the base
+  uint64_t counter_base[32];
+
+  // Sv39 translations, one direct-mapped TLB each for user and supervisor accesses
+  struct TlbEntry
+  {
+      uint64_t vpn;
+      uint64_t ppn;           // 4KB page, superpages are cached one 4KB page at a time
+      uint16_t asid;
+      uint8_t pte;            // V, R, W, X, U, G, A and D bits of the leaf
+      uint8_t level;          // 0 for a 4KB leaf, 1 or 2 for a slice of a 2MB or 1GB superpage
+      bool valid;
+  };
+  static const unsigned int tlb_bits = 8;
+  TlbEntry tlb[2][1 << tlb_bits];
+  uint64_t tlb_hits;
+  uint64_t tlb_misses;
+  uint64_t page_walks;
+  bool paging;                // satp selects Sv39, otherwise every access is physical without further checks
+  bool access_fault;          // the current instruction took a page or access fault, its remaining accesses and results are dropped
+
+  // physical memory protection, 16 entries of 8-byte granularity mirrored from pmpcfg and pmpaddr
+  struct PmpRegion
+  {
+      uint64_t low;           // matched bytes are low <= address < high, empty when off
+      uint64_t high;
+      uint8_t cfg;
+  };
+  PmpRegion pmp_regions[16];
+  bool pmp_active;            // some entry is not off, otherwise every access is allowed
+  bool pmp_locked;            // some active entry is locked, otherwise machine mode is never checked
+
+  // decisions per 4KB physical page, cleared by any pmp csr write, perm holds the rwx bits
+  // below machine mode in bits 2:0, in machine mode in bits 5:3, and bit 6 for a page
+  // straddling a region boundary that is checked per access
+  struct PmpPage
+  {
+      uint64_t page;
+      uint8_t perm;
+      bool valid;
+  };
+  static const unsigned int pmp_cache_bits = 10;
+  PmpPage pmp_cache[1 << pmp_cache_bits];
+
   // stage 2 variables
   unsigned int prv;
   unordered_map<unsigned int,uint64_t> csrs;
@@ -54,7 +176,10 @@ class processor {
   void set_reg(unsigned int reg_num, uint64_t new_value);
 
   // Execute a number of instructions
-  void execute(unsigned int num, bool breakpoint_check);
+  void execute(uint64_t num, bool breakpoint_check);
+
+  // Execute until a breakpoint or halt condition is reached
+  void run();
 
   // Clear breakpoint
   void clear_breakpoint();
@@ -62,6 +187,24 @@ class processor {
   // Set breakpoint at an address
   void set_breakpoint(uint64_t address);
 
+  // Halt on ebreak
+  void set_halt_ebreak();
+
+  // Halt on ecall with a7 equal to value
+  void set_halt_ecall(uint64_t value);
+
+  // Halt on a store to the tohost address
+  void set_halt_tohost(uint64_t address);
+
+  // Limit the number of instructions executed by run (0 = no limit)
+  void set_halt_count(uint64_t count);
+
+  // Limit the host seconds spent by run (0 = no limit)
+  void set_halt_time(uint64_t seconds);
+
+  // Clear all halt conditions
+  void clear_halt();
+
   // Show privilege level
   // Empty implementation for stage 1, required for stage 2
   void show_prv();
@@ -80,12 +223,159 @@ class processor {
 
   uint64_t get_instruction_count();
 
+  // Attach a timing model
+  void set_timing_model(TimingModel* timing);
+
+  // Attach instruction and data cache models
+  void set_caches(Cache* icache, Cache* dcache);
+
+  // Attach a cache sweep
+  void set_cache_sweep(CacheSweep* sweep);
+
+  // Attach a branch prediction unit
+  void set_branch_unit(BranchUnit* branch_unit);
+
+  // Run the timing model and branch predictors on a separate thread
+  void set_timing_thread(TimingThread* timing_thread);
+
+  // Attach an analytical cost model
+  void set_cost_model(CostModel* cost_model);
+
+  // Attach a CLINT timer device
+  void set_clint(Clint* clint);
+
+  // Load an interrupt and event schedule, false on error
+  bool load_events(string file_name);
+
+  // Return instruction names indexed by code
+  const vector<string>& get_ins_names();
+
+  // returns the host seconds spent executing instructions
+  double get_host_seconds();
+
+  // returns the ticks skipped while waiting in wfi
+  uint64_t get_idle_ticks();
+
+  // Skip spin loops that wait for an event
+  void set_skip_spin(bool enabled);
+
+  // Set the vector register length in bits, returning false if unsupported
+  bool set_vlen(unsigned int bits);
+
+  // returns the instructions skipped in spin loops
+  uint64_t get_spin_skipped();
+
+  // returns TLB lookups that hit and missed, and page table walks
+  uint64_t get_tlb_hits();
+  uint64_t get_tlb_misses();
+  uint64_t get_page_walks();
+
   // Used for Postgraduate assignment. Undergraduate assignment can return 0.
   uint64_t get_cycle_count();
 
   // execute current instruction
   void executeIns();
 
+  // current time for the cache models
+  uint64_t cache_time();
+
+  // update mip from the CLINT and schedule its next expiry
+  void update_clint();
+
+  // handle events due at the current tick
+  void service_events();
+
+  // return device time in ticks
+  uint64_t ticks()
+  {
+      return ins_count + idle_ticks;
+  }
+
+  // wait for an interrupt, skipping idle time to the next event
+  void wait_for_interrupt();
+
+  // at a backward transfer from branch_pc, skip whole iterations of an unchanging loop
+  // up to the next event and at most budget instructions, returning instructions skipped
+  uint64_t skip_spin(uint64_t branch_pc, uint64_t budget);
+
+  // translate a virtual address for a fetch (0), load (1) or store (2) while paging, raising a page fault on failure
+  bool translate(uint64_t vaddr, int access, uint64_t& paddr);
+
+  // walk the Sv39 page table for vaddr and refill entry, returning 0 or the cause of a page or access fault
+  int page_walk(uint64_t vaddr, int access, unsigned int eff_prv, TlbEntry& entry);
+
+  // return true if a leaf pte allows the access at privilege eff_prv
+  bool pte_permits(uint64_t pte, int access, unsigned int eff_prv);
+
+  // check a fetch (0), load (1) or store (2) at physical address paddr against pmp, raising an access fault on failure
+  bool pmp_check(uint64_t vaddr, uint64_t paddr, int access);
+
+  // return true if pmp allows the access to paddr at privilege eff_prv
+  bool pmp_allows(uint64_t paddr, int access, unsigned int eff_prv);
+
+  // return the permission bits of the first entry matching any of the size bytes at base, as cached per page
+  uint8_t pmp_permissions(uint64_t base, uint64_t size);
+
+  // write a pmpcfg or pmpaddr register and rebuild the regions
+  void set_pmp(unsigned int csr_num, uint64_t new_value);
+
+  // invalidate TLB entries for a virtual address and address space, all when the register is x0
+  void sfence_vma(unsigned int rs1, unsigned int rs2);
+
+  // read doubleword from memory through the data cache model
+  uint64_t load_doubleword(uint64_t address);
+
+  // write doubleword to memory through the data cache model and check for tohost halt
+  void store_doubleword(uint64_t address, uint64_t data, uint64_t mask);
+
+  // execute F and D instructions
+  void executeFloat();
+
+  // execute an F or D operation on single or double values, op is the single form
+  template <typename T> void executeFloatOp(Ins op);
+
+  // convert to an integer of bits width, saturating and raising invalid as RISC-V requires
+  template <typename T> uint64_t float_to_int(T value, bool is_signed, unsigned int bits, uint8_t rm);
+
+  // set the host rounding mode for rm
+  void set_round(uint8_t rm);
+
+  // fold host floating point exception flags into fflags and clear them
+  void sync_fflags();
+
+  // read floating point registers, singles that are not NaN-boxed read as the canonical NaN
+  void read_freg(unsigned int reg, float& value);
+  void read_freg(unsigned int reg, double& value);
+
+  // write floating point registers, NaN-boxing singles
+  void write_freg(unsigned int reg, float value);
+  void write_freg(unsigned int reg, double value);
+
+  // element operations of the vector arithmetic loop
+  enum VectorOp { vop_add, vop_sub, vop_rsub, vop_minu, vop_min, vop_maxu, vop_max, vop_and, vop_or, vop_xor,
+                  vop_sll, vop_srl, vop_sra, vop_mul, vop_macc, vop_mv };
+
+  // execute vector instructions
+  void executeVector();
+
+  // vsetvli, vsetivli and vsetvl
+  void vector_config();
+
+  // unit-stride and strided loads and stores of eew-byte elements
+  void vector_memory(bool store, unsigned int eew, uint64_t stride);
+
+  // element-wise arithmetic, or a reduction into element 0 of vd, on sew-bit elements of type T
+  template <typename T> void vector_arith(VectorOp op, bool reduction);
+
+  // current value of the event source behind counter index (0 cycle, 1 time, 2 instret, 3-31 mhpmevent)
+  uint64_t counter_source(unsigned int index);
+
+  // read a csr, computing the counters from their event sources
+  uint64_t read_csr(unsigned int csr_num);
+
+  // return true for the vector csrs
+  bool is_vector_csr(unsigned int csr_num);
+
   // sign extend 12-bit to 32-bit
   uint32_t sext_12_32(uint32_t val);
 
@@ -104,11 +394,23 @@ class processor {
   // performed signed comparison of two 64-bit values
   bool signedComp(uint64_t a, uint64_t b);
 
+  // write a csr from a csr instruction
+  void csr_ins_write(unsigned int csr_num, uint64_t new_value);
+
+  // return true if the current instruction may access csr_num, writing if write is set
+  bool csr_accessible(unsigned int csr_num, bool write);
+
   // initialise control and status registers
   void initCSRs();
 
-  // return from machine trap
-  void except(int cause);
+  // jump or take a branch to target, linking rd
+  void jump(uint64_t target, unsigned int rd);
+
+  // return from machine trap, tval is the faulting address of page faults or the misaligned pc
+  void except(int cause, uint64_t tval = 0);
+
+  // take a trap delegated to supervisor mode
+  void supervisor_trap(uint64_t cause, uint64_t tval);
 
   // interrupt routine
   void interrupt(int cause);
@@ -6,11 +6,22 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <sstream>
+#include <vector>
 #include <stdlib.h>
 
 #include "memory.h"
 #include "processor.h"
 #include "commands.h"
+#include "Pipeline.h"
+#include "OutOfOrder.h"
+#include "Cache.h"
+#include "CacheSweep.h"
+#include "BranchUnit.h"
+#include "TimingThread.h"
+#include "CostModel.h"
+#include "KonataTrace.h"
+#include "Clint.h"
 
 using namespace std;
 
@@ -22,8 +33,70 @@ int main(int argc, char* argv[]) {
     bool cycle_reporting = false;
     bool stage2 = true;
 
+    // pipeline timing model options
+    bool pipeline_model = false;
+    unsigned int load_use_latency = 1;
+    unsigned int branch_penalty = 2;
+    unsigned int jump_penalty = 1;
+    unsigned int trap_latency = 3;
+    unsigned int csr_latency = 2;
+
+    // out-of-order timing model options
+    bool ooo_model = false;
+    unsigned int fetch_width = 4;
+    unsigned int rob_size = 64;
+    unsigned int iq_size = 32;
+    unsigned int phys_regs = 128;
+    unsigned int alu_units = 3;
+    unsigned int lsu_units = 2;
+
+    // cache hierarchy options, empty specification when disabled
+    string l1i_spec;
+    string l1d_spec;
+    string l2_spec;
+    unsigned int l2_latency = 10;
+    unsigned int mem_latency = 100;
+
+    // cache sweep stream, 0 when disabled
+    char sweep_stream = 0;
+
+    // L1D prefetcher, empty when disabled
+    string prefetcher_name;
+
+    // DRAM model behind the last level cache, empty when disabled
+    string dram_spec;
+    string dram_timing = "40:40:40:10";
+
+    // branch predictors, empty when disabled
+    vector<string> predictor_names;
+
     memory* main_memory;
     processor* cpu;
+    TimingModel* timing = NULL;
+    Cache* l1i = NULL;
+    Cache* l1d = NULL;
+    Cache* l2 = NULL;
+    CacheSweep* sweep = NULL;
+    Dram* dram = NULL;
+    BranchUnit* branch_unit = NULL;
+    TimingThread* timing_thread = NULL;
+    bool threaded = false;
+    string cost_file;
+    CostModel* cost_model = NULL;
+
+    // pipeline trace of a window of retired instructions
+    string trace_file;
+    uint64_t trace_start = 0;
+    uint64_t trace_count = 100000;
+    KonataTrace* trace = NULL;
+
+    // CLINT timer device
+    bool clint_enabled = false;
+    unsigned int clint_ratio = 1;
+    Clint* clint = NULL;
+    string event_file;
+    bool cpu_skip_spin = false;
+    unsigned int vlen = 128;
 
     unsigned long int cpu_instruction_count;
     
@@ -34,6 +107,81 @@ int main(int argc, char* argv[]) {
             verbose = true;
         else if (arg == "-c")  // Cycle and instruction reporting enabled
             cycle_reporting = true;
+        else if (arg == "-p")  // In-order pipeline timing model enabled
+            pipeline_model = true;
+        else if (arg == "-load-use" && i + 1 < argc)  // Load-use latency in cycles
+            load_use_latency = atoi(argv[++i]);
+        else if (arg == "-branch-penalty" && i + 1 < argc)  // Taken branch penalty in cycles
+            branch_penalty = atoi(argv[++i]);
+        else if (arg == "-jump-penalty" && i + 1 < argc)  // jal penalty in cycles
+            jump_penalty = atoi(argv[++i]);
+        else if (arg == "-trap-latency" && i + 1 < argc)  // Trap entry latency in cycles
+            trap_latency = atoi(argv[++i]);
+        else if (arg == "-csr-latency" && i + 1 < argc)  // CSR access latency in cycles
+            csr_latency = atoi(argv[++i]);
+        else if (arg == "-o")  // Out-of-order timing model enabled
+            ooo_model = true;
+        else if (arg == "-fetch-width" && i + 1 < argc)  // Fetch, dispatch and commit width
+            fetch_width = atoi(argv[++i]);
+        else if (arg == "-rob" && i + 1 < argc)  // Reorder buffer entries
+            rob_size = atoi(argv[++i]);
+        else if (arg == "-iq" && i + 1 < argc)  // Issue queue entries
+            iq_size = atoi(argv[++i]);
+        else if (arg == "-prf" && i + 1 < argc)  // Physical registers
+            phys_regs = atoi(argv[++i]);
+        else if (arg == "-alu" && i + 1 < argc)  // ALUs
+            alu_units = atoi(argv[++i]);
+        else if (arg == "-lsu" && i + 1 < argc)  // Load/store units
+            lsu_units = atoi(argv[++i]);
+        else if (arg == "-cache") {  // Default cache hierarchy enabled
+            l1i_spec = "32k:8:64";
+            l1d_spec = "32k:8:64";
+            l2_spec = "256k:8:64";
+        }
+        else if (arg == "-l1i" && i + 1 < argc)  // L1 instruction cache
+            l1i_spec = argv[++i];
+        else if (arg == "-l1d" && i + 1 < argc)  // L1 data cache
+            l1d_spec = argv[++i];
+        else if (arg == "-l2" && i + 1 < argc)  // Unified L2 cache
+            l2_spec = argv[++i];
+        else if (arg == "-l2-latency" && i + 1 < argc)  // L2 hit latency in cycles
+            l2_latency = atoi(argv[++i]);
+        else if (arg == "-mem-latency" && i + 1 < argc)  // Memory latency in cycles
+            mem_latency = atoi(argv[++i]);
+        else if (arg == "-sweep" && i + 1 < argc &&  // Cache sweep of instruction, data or unified stream
+                 (string(argv[i + 1]) == "i" || string(argv[i + 1]) == "d" || string(argv[i + 1]) == "u"))
+            sweep_stream = argv[++i][0];
+        else if (arg == "-dram" && i + 1 < argc)  // DRAM model geometry and page policy
+            dram_spec = argv[++i];
+        else if (arg == "-dram-timing" && i + 1 < argc)  // DRAM tCAS:tRCD:tRP:burst in cycles
+            dram_timing = argv[++i];
+        else if (arg == "-prefetch" && i + 1 < argc)  // L1D prefetcher
+            prefetcher_name = argv[++i];
+        else if (arg == "-cost" && i + 1 < argc)  // Analytical cost table
+            cost_file = argv[++i];
+        else if (arg == "-trace" && i + 1 < argc)  // Kanata pipeline trace file
+            trace_file = argv[++i];
+        else if (arg == "-trace-start" && i + 1 < argc)  // First traced instruction
+            trace_start = strtoull(argv[++i], NULL, 10);
+        else if (arg == "-trace-count" && i + 1 < argc)  // Number of traced instructions
+            trace_count = strtoull(argv[++i], NULL, 10);
+        else if (arg == "-clint")  // CLINT timer at 0x2000000
+            clint_enabled = true;
+        else if (arg == "-clint-ratio" && i + 1 < argc)  // Instructions per mtime tick
+            clint_ratio = atoi(argv[++i]);
+        else if (arg == "-events" && i + 1 < argc)  // Interrupt and event schedule
+            event_file = argv[++i];
+        else if (arg == "-skip-spin")  // Skip spin loops waiting for an event
+            cpu_skip_spin = true;
+        else if (arg == "-vlen" && i + 1 < argc)  // Vector register length in bits
+            vlen = atoi(argv[++i]);
+        else if (arg == "-threaded")  // Timing model on a separate thread
+            threaded = true;
+        else if (arg == "-bp" && i + 1 < argc) {  // Branch predictors, comma separated
+            stringstream names(argv[++i]);
+            string name;
+            while (getline(names, name, ',')) predictor_names.push_back(name);
+        }
         else {
             cout << "Unknown option: " << arg << endl;
         }
@@ -42,8 +190,107 @@ int main(int argc, char* argv[]) {
     main_memory = new memory (verbose);
     cpu = new processor (main_memory, verbose, stage2);
 
+    // L1 hits are part of the pipeline, L2 and memory latency add to it
+    if (l2_spec != "") {
+        l2 = Cache::create("L2", l2_spec, l2_latency);
+        if (l2 != NULL) l2->setMemoryLatency(mem_latency);
+    }
+    if (l1i_spec != "") {
+        l1i = Cache::create("L1I", l1i_spec, 0);
+        if (l1i != NULL) {
+            l1i->setNext(l2);
+            l1i->setMemoryLatency(mem_latency);
+        }
+    }
+    if (l1d_spec != "") {
+        l1d = Cache::create("L1D", l1d_spec, 0);
+        if (l1d != NULL) {
+            l1d->setNext(l2);
+            l1d->setMemoryLatency(mem_latency);
+        }
+    }
+    if (dram_spec != "") {
+        dram = Dram::create(dram_spec, dram_timing);
+        if (dram != NULL && l2 != NULL) l2->setDram(dram);
+        else if (dram != NULL && (l1i != NULL || l1d != NULL)) {
+            if (l1i != NULL) l1i->setDram(dram);
+            if (l1d != NULL) l1d->setDram(dram);
+        }
+        else if (dram != NULL) {
+            cout << "DRAM model requires a cache" << endl;
+            delete dram;
+            dram = NULL;
+        }
+    }
+    if (prefetcher_name != "" && prefetcher_name != "none") {
+        Prefetcher* prefetcher = Prefetcher::create(prefetcher_name);
+        if (prefetcher == NULL) cout << "Unknown prefetcher: " << prefetcher_name << endl;
+        else if (l1d == NULL) {
+            cout << "Prefetcher requires an L1D cache" << endl;
+            delete prefetcher;
+        }
+        else l1d->setPrefetcher(prefetcher);
+    }
+    cpu->set_caches(l1i, l1d);
+
+    if (sweep_stream != 0) {
+        sweep = new CacheSweep (sweep_stream);
+        cpu->set_cache_sweep(sweep);
+    }
+
+    // first predictor drives the timing model
+    if (!predictor_names.empty()) {
+        branch_unit = new BranchUnit ();
+        for (size_t j = 0; j < predictor_names.size(); j++) {
+            BranchPredictor* predictor = BranchPredictor::create(predictor_names[j]);
+            if (predictor != NULL) branch_unit->addPredictor(predictor);
+            else cout << "Unknown branch predictor: " << predictor_names[j] << endl;
+        }
+        cpu->set_branch_unit(branch_unit);
+    }
+
+    if (ooo_model) {
+        timing = new OutOfOrder (fetch_width, rob_size, iq_size, phys_regs, alu_units, lsu_units);
+        cpu->set_timing_model(timing);
+    }
+    else if (pipeline_model) {
+        timing = new Pipeline (load_use_latency, branch_penalty, jump_penalty, trap_latency, csr_latency);
+        cpu->set_timing_model(timing);
+    }
+
+    if (clint_enabled) {
+        clint = new Clint (0x2000000, clint_ratio);
+        cpu->set_clint(clint);
+    }
+
+    if (event_file != "") cpu->load_events(event_file);
+    cpu->set_skip_spin(cpu_skip_spin);
+    if (!cpu->set_vlen(vlen)) cout << "Unsupported VLEN " << dec << vlen << ", using 128" << endl;
+
+    if (trace_file != "") {
+        if (timing == NULL) cout << "Pipeline trace requires a timing model" << endl;
+        else {
+            trace = new KonataTrace (trace_file, cpu->get_ins_names(), trace_start, trace_count);
+            timing->setTrace(trace);
+        }
+    }
+
+    if (cost_file != "") {
+        cost_model = CostModel::load(cost_file, cpu->get_ins_names());
+        if (cost_model != NULL) cpu->set_cost_model(cost_model);
+    }
+
+    if (threaded && (timing != NULL || branch_unit != NULL)) {
+        timing_thread = new TimingThread (timing, branch_unit, 4096);
+        cpu->set_timing_thread(timing_thread);
+    }
+
     interpret_commands(main_memory, cpu, verbose);
 
+    // Finish consuming retired instructions before reporting
+    if (timing_thread != NULL) timing_thread->stop();
+    if (trace != NULL) trace->close();
+
     // Report final statistics
 
     cpu_instruction_count = cpu->get_instruction_count();
@@ -56,5 +303,34 @@ int main(int argc, char* argv[]) {
         cpu_cycle_count = cpu->get_cycle_count();
 
         cout << "CPU cycle count: " << dec << cpu_cycle_count << endl;
+
+        if (timing != NULL) timing->printStats();
+        if (timing_thread != NULL) timing_thread->printStats();
+        if (cpu->get_idle_ticks() != 0) cout << "Idle cycles skipped in wfi: " << dec << cpu->get_idle_ticks() << endl;
+        if (cpu->get_spin_skipped() != 0) cout << "Spin loop instructions skipped: " << dec << cpu->get_spin_skipped() << endl;
+        if (cost_model != NULL) cost_model->printStats();
+
+        // host throughput
+        double host_seconds = cpu->get_host_seconds();
+
+        cout << "Host seconds: " << host_seconds << endl;
+        if (host_seconds > 0)
+            cout << "MIPS: " << cpu_instruction_count / host_seconds / 1e6 << endl;
+    }
+
+    // Report cache statistics
+    if (l1i != NULL) l1i->printStats();
+    if (l1d != NULL) l1d->printStats();
+    if (l2 != NULL) l2->printStats();
+    if (dram != NULL) dram->printStats();
+    if (sweep != NULL) sweep->printStats();
+
+    // Report address translation statistics when paging was used
+    if (cpu->get_tlb_hits() + cpu->get_tlb_misses() != 0) {
+        cout << "TLB hits: " << dec << cpu->get_tlb_hits() << ", misses: " << cpu->get_tlb_misses()
+             << ", page walks: " << cpu->get_page_walks() << endl;
     }
+
+    // Report branch prediction statistics
+    if (branch_unit != NULL) branch_unit->printStats();
 }